@@ -0,0 +1,60 @@
+###################################################################################
+# Author		: Mahmoud Karam Emara (ma.karam272@gmail.com)
+# Version		: 1.0.0
+# Date 			: 18 May 2022
+# Description	: makefile of the schedulability analyzer (see analyzer/analyzer.c):
+#					<make -f analyzer.mk all>
+#					* Build the analyzer with the task set of
+#					  code/include/cuteOS_tasks_cfg.h and run it: prints the
+#					  utilization and the worst-case busy tick, and fails if the
+#					  work of a tick does not end before the next tick
+#					<make -f analyzer.mk all DEFINES=-DCUTEOS_CFG_STATIC=1>
+#					* Same, with the tick time of the static task set
+#					  (CUTEOS_CFG_STATIC_TICK): checks it against the periods
+#					  and suggests the longest valid one
+###################################################################################
+
+#---------------------------------------------------------------------------------#
+# TOOLS: ----CHANGE THESE AS NEEDED----											  #
+#---------------------------------------------------------------------------------#
+CC		= gcc
+CFLAGS	= -std=c99 -O2 -Wall
+RM		= rm -rf
+
+
+
+#---------------------------------------------------------------------------------#
+# TARGET FILES & DIRECTORIES: ----CHANGE THESE AS NEEDED----					  #
+#---------------------------------------------------------------------------------#
+# INC_DIR: Directory of the header files (the task set is cuteOS_tasks_cfg.h)
+INC_DIR		= code/include
+# ANALYZER_DIR: Directory of the analyzer sources
+ANALYZER_DIR	= analyzer
+# BUILD_DIR: Directory where the generated files will be placed
+BUILD_DIR	= build/analyzer
+# DEFINES: Kernel configuration of the application (see code/include/cuteOS_cfg.h)
+DEFINES		=
+
+
+
+#---------------------------------------------------------------------------------#
+# GENERATION OF FILES: ----DO NOT CHANGE ANYTHING BELOW THIS LINE----			  #
+#---------------------------------------------------------------------------------#
+ANALYZER	= ${BUILD_DIR}/analyzer
+
+# all : build and run the analyzer
+all	: ${ANALYZER}
+	@${ANALYZER}
+
+# The analyzer is rebuilt at every run: the task set and the options may change
+${ANALYZER} : FORCE
+	@mkdir -p ${BUILD_DIR}
+	@${CC} ${CFLAGS} ${DEFINES} -I${INC_DIR} -o $@ ${ANALYZER_DIR}/analyzer.c
+
+# clean : remove all generated files
+clean :
+	@-${RM} ${BUILD_DIR}
+
+# Phony targets: targets that are not really files, but are used to
+# control the build process.
+.PHONY	: clean all FORCE
@@ -0,0 +1,290 @@
+/********************************************************************************
+ * @file    analyzer.c
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Host tool: schedulability analysis of the task set of
+ * 			\ref cuteOS_tasks_cfg.h.
+ * @details Built with the same headers and options as the kernel, so it
+ * 			reads the same task declarations: the periods of
+ * 			\ref CUTEOS_CFG_STATIC_TASKS and the budgets (worst-case
+ * 			execution times) of \ref CUTEOS_CFG_TASK_BUDGETS. It prints:
+ * 			- The tick time, in the time unit \ref CUTEOS_CFG_TIME_UNIT_US
+ * 			  of the periods: with \ref CUTEOS_CFG_STATIC, the one given by
+ * 			  \ref CUTEOS_CFG_STATIC_TICK, checked against the periods and
+ * 			  \ref CUTEOS_MAX_TICK_TIME like the kernel does, and the
+ * 			  longest valid one as a suggestion. Otherwise, the one
+ * 			  computed by \ref cuteOS_GCD().
+ * 			- The utilization of each task and of the task set.
+ * 			- The worst-case busy tick: the tick with the most work to do,
+ * 			  the work released at it plus the work left from the ticks
+ * 			  before, and the tasks released at it.
+ * 			- The busy period: the number of ticks until that work is done.
+ *
+ * 			All the tasks are released at the same tick once per
+ * 			hyperperiod (no offsets), which is the worst case: the busy
+ * 			period that starts there is the longest one, so it is
+ * 			simulated tick by tick (at most one hyperperiod). With
+ * 			\ref CUTEOS_CFG_BALANCE the kernel spreads the releases, so the
+ * 			real ticks can only be lighter.
+ *
+ * 			The task set is schedulable when the work of each tick ends
+ * 			before the next tick, the check of \ref cuteOS_TaskCreateBudget().
+ * 			The exit status is 1 otherwise, so the build can fail on it.
+ * 			Usage: analyzer
+ * @note    A host program, not built for the 8051. See analyzer.mk.
+ * @version 1.0.0
+ * @date    2022-05-18
+ * @copyright Copyright (c) 2022
+ ********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "STD_TYPES.h"
+#include "main.h"
+#include "hal.h"
+#include "cuteOS_cfg.h"
+#include "cuteOS.h"
+#include "cuteOS_tasks_cfg.h"
+
+#define MAX_SIM_TICKS		100000000UL	/*!< Longest busy period simulated */
+
+/*------------------------------------------------------------------------------*/
+/*	THE TASK SET, FROM cuteOS_tasks_cfg.h								  		*/
+/*------------------------------------------------------------------------------*/
+typedef struct {
+	const char *name;
+	unsigned long period;		/*!< In time units (CUTEOS_CFG_TIME_UNIT_US) */
+	unsigned long wcet_us;		/*!< 0: no budget */
+	unsigned long ticks;		/*!< Period in ticks */
+} TASK_t;
+
+typedef struct {
+	const char *name;
+	unsigned long wcet_us;
+} BUDGET_t;
+
+#define ANALYZER_TASK(CALLBACK, PERIOD, PRIORITY)	{ #CALLBACK, (PERIOD), 0, 0 },
+#define ANALYZER_BUDGET(CALLBACK, WCET_US)				{ #CALLBACK, (WCET_US) },
+
+static TASK_t tasks[] = {
+	CUTEOS_CFG_STATIC_TASKS(ANALYZER_TASK)
+};
+
+static const BUDGET_t budgets[] = {
+	CUTEOS_CFG_TASK_BUDGETS(ANALYZER_BUDGET)
+};
+
+#define TASKS_NUM	( sizeof(tasks) / sizeof(tasks[0]) )
+#define BUDGETS_NUM	( sizeof(budgets) / sizeof(budgets[0]) )
+
+/*------------------------------------------------------------------------------*/
+/*	PRIVATE FUNCTIONS													  		*/
+/*------------------------------------------------------------------------------*/
+static unsigned long gcd2(unsigned long x, unsigned long y) {
+	unsigned long remainder;
+
+	while(y != 0) {
+		remainder = x % y;
+		x = y;
+		y = remainder;
+	}
+
+	return x;
+}
+
+/**
+ * @brief	GCD of the periods of the task set, in time units.
+ */
+static unsigned long periods_gcd(void) {
+	unsigned long gcd = 0;
+	size_t i;
+
+	for(i = 0; i < TASKS_NUM; ++i) {
+		gcd = gcd2(gcd, tasks[i].period);
+	}
+
+	return gcd;
+}
+
+#if CUTEOS_CFG_STATIC
+/**
+ * @brief	Longest valid tick time of the static task set, in time units: the
+ * 			largest divisor of the periods up to \ref CUTEOS_MAX_TICK_TIME.
+ */
+static unsigned long best_static_tick(void) {
+	const unsigned long GCD = periods_gcd();
+	unsigned long tick = (GCD < CUTEOS_MAX_TICK_TIME) ? GCD : CUTEOS_MAX_TICK_TIME;
+
+	while( (tick > 1) && ((GCD % tick) != 0) ) {
+		--tick;
+	}
+
+	return (0 == tick) ? 1 : tick;
+}
+
+/**
+ * @brief	Check \ref CUTEOS_CFG_STATIC_TICK like the kernel does at compile
+ * 			time, naming the tasks it does not divide.
+ * @return	0 if the tick time is valid, 1 otherwise.
+ */
+static int check_static_tick(void) {
+	const unsigned long TICK = CUTEOS_CFG_STATIC_TICK;
+	int bad = 0;
+	size_t i;
+
+	if( (TICK < 1) || (TICK > CUTEOS_MAX_TICK_TIME) ) {
+		printf("CUTEOS_CFG_STATIC_TICK %lu is not 1 to %lu time units (one Timer 2 period)\n",
+			   TICK, (unsigned long)CUTEOS_MAX_TICK_TIME);
+		return 1;
+	}
+	for(i = 0; i < TASKS_NUM; ++i) {
+		if( (0 == tasks[i].period) || ((tasks[i].period % TICK) != 0) ) {
+			printf("CUTEOS_CFG_STATIC_TICK %lu does not divide the period %lu of %s\n", TICK, tasks[i].period, tasks[i].name);
+			bad = 1;
+		}
+	}
+
+	return bad;
+}
+#endif
+
+/**
+ * @brief	Tick time of the task set in time units, as used by the kernel.
+ */
+static unsigned long tick_time(void) {
+	unsigned long tick;
+
+#if CUTEOS_CFG_STATIC
+	tick = CUTEOS_CFG_STATIC_TICK;
+#else
+	/*!< The GCD, divided by its smallest factors down to the maximum (cuteOS_GCD()) */
+	unsigned long divisor = 2;
+
+	tick = periods_gcd();
+	while(tick > CUTEOS_MAX_TICK_TIME) {
+		while((tick % divisor) != 0) {
+			++divisor;
+		}
+		tick /= divisor;
+	}
+#endif
+
+	return (tick <= 1) ? 1 : tick;
+}
+
+/**
+ * @brief	Print the names of the tasks released at a tick.
+ */
+static void print_released(const unsigned long TICK) {
+	size_t i;
+
+	for(i = 0; i < TASKS_NUM; ++i) {
+		if(0 == (TICK % tasks[i].ticks)) {
+			printf(" %s", tasks[i].name);
+		}
+	}
+	printf("\n");
+}
+
+/*------------------------------------------------------------------------------*/
+/*	MAIN FUNCTION														  		*/
+/*------------------------------------------------------------------------------*/
+int main(void) {
+	const unsigned long TICK = tick_time();
+	const unsigned long TICK_US = TICK * CUTEOS_CFG_TIME_UNIT_US;
+	unsigned long hyperperiod = 1;
+	unsigned long tick;
+	unsigned long work;
+	unsigned long backlog = 0;
+	unsigned long worst = 0;
+	unsigned long worst_tick = 0;
+	unsigned long busy_ticks = 0;
+	double utilization = 0.0;
+	size_t i;
+	size_t j;
+	int missing = 0;
+
+	/*!< Join the budgets to the tasks by function name */
+	for(j = 0; j < BUDGETS_NUM; ++j) {
+		for(i = 0; (i < TASKS_NUM) && (strcmp(tasks[i].name, budgets[j].name) != 0); ++i) {
+		}
+		if(i < TASKS_NUM) {
+			tasks[i].wcet_us = budgets[j].wcet_us;
+		} else {
+			fprintf(stderr, "analyzer: budget of %s, which is not in the task set\n", budgets[j].name);
+		}
+	}
+
+	printf("Task set: %u tasks, tick time %lu us (%s task set)\n",
+		   (unsigned)TASKS_NUM, TICK_US, CUTEOS_CFG_STATIC ? "static" : "dynamic");
+#if CUTEOS_CFG_STATIC
+	if(best_static_tick() != TICK) {
+		printf("Suggested CUTEOS_CFG_STATIC_TICK: %lu (%lu us), the longest tick that divides all the periods\n",
+			   best_static_tick(), best_static_tick() * CUTEOS_CFG_TIME_UNIT_US);
+	}
+	if(check_static_tick() != 0) {
+		printf("\nINVALID TICK TIME: the kernel does not build with it\n");
+		return EXIT_FAILURE;
+	}
+#endif
+	printf("\n");
+	printf("%-24s %10s %10s %10s\n", "task", "period_us", "wcet_us", "util_%");
+	for(i = 0; i < TASKS_NUM; ++i) {
+		tasks[i].ticks = tasks[i].period / TICK;
+		hyperperiod = (hyperperiod / gcd2(hyperperiod, tasks[i].ticks)) * tasks[i].ticks;
+		utilization += (double)tasks[i].wcet_us / ((double)tasks[i].period * CUTEOS_CFG_TIME_UNIT_US);
+		if(0 == tasks[i].wcet_us) {
+			++missing;
+			printf("%-24s %10lu %10s %10s\n", tasks[i].name, tasks[i].period * CUTEOS_CFG_TIME_UNIT_US, "-", "-");
+		} else {
+			printf("%-24s %10lu %10lu %10.3f\n", tasks[i].name, tasks[i].period * CUTEOS_CFG_TIME_UNIT_US, tasks[i].wcet_us,
+				   (100.0 * tasks[i].wcet_us) / ((double)tasks[i].period * CUTEOS_CFG_TIME_UNIT_US));
+		}
+	}
+	printf("\nUtilization: %.3f %%\n", 100.0 * utilization);
+	if(missing != 0) {
+		printf("Warning: %d tasks without a budget are counted as 0 us\n", missing);
+	}
+
+	/*!< Simulate the busy period that starts when all the tasks are released together */
+	for(tick = 0; tick < MAX_SIM_TICKS; ++tick) {
+		work = backlog;
+		for(i = 0; i < TASKS_NUM; ++i) {
+			if(0 == (tick % tasks[i].ticks)) {
+				work += tasks[i].wcet_us;
+			}
+		}
+		if(work > worst) {
+			worst = work;
+			worst_tick = tick;
+		}
+		backlog = (work > TICK_US) ? (work - TICK_US) : 0;
+		if(0 == backlog) {
+			busy_ticks = tick + 1;
+			break;
+		}
+		if(tick >= hyperperiod) {
+			break;				/*!< The work never ends: overloaded */
+		}
+	}
+
+	printf("Worst-case busy tick: tick %lu (%lu us after the common release), %lu us of %lu us (%.1f %%)\n",
+		   worst_tick, worst_tick * TICK_US, worst, TICK_US, (100.0 * worst) / TICK_US);
+	printf("Released at it:");
+	print_released(worst_tick);
+
+	if(backlog != 0) {
+		printf("Busy period: never ends, the task set is overloaded\n");
+	} else {
+		printf("Busy period: %lu tick%s\n", busy_ticks, (1 == busy_ticks) ? "" : "s");
+	}
+
+	if(worst > TICK_US) {
+		printf("\nNOT SCHEDULABLE: the work of a tick does not end before the next tick\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("\nSchedulable: the work of each tick ends before the next tick (%.1f %% margin)\n",
+		   100.0 - ((100.0 * worst) / TICK_US));
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+###################################################################################
+# Author		: Mahmoud Karam Emara (ma.karam272@gmail.com)
+# Version		: 1.0.0
+# Date 			: 28 April 2022
+# Description	: makefile of the scheduler benchmark suite (see bench/bench.c):
+#					<make -f bench.mk all>
+#					* Build every configuration of the matrix (tasks counts x
+#					  periods mixes) with SDCC, run each one on the ucsim 8051
+#					  simulator and write the results in build/bench/ucsim.csv
+#					  (values in instruction cycles)
+#					<make -f bench.mk posix>
+#					* Same matrix, built and run natively with the POSIX HAL,
+#					  results in build/bench/posix.csv (not cycle accurate)
+#				  Requires: sdcc, s51 (ucsim, shipped with SDCC) and timeout
+#				  (coreutils) in the PATH
+###################################################################################
+
+#---------------------------------------------------------------------------------#
+# TOOLS: ----CHANGE THESE AS NEEDED----											  #
+#---------------------------------------------------------------------------------#
+SDCC		= sdcc
+SDCC_FLAGS	= -mmcs51 --model-small --std-sdcc99 --opt-code-speed
+UCSIM		= s51
+UCSIM_FLAGS	= -t 8052 -X 12M
+TIMEOUT		= timeout
+# UCSIM_TIMEOUT: Longest run of one configuration in ucsim, in seconds
+UCSIM_TIMEOUT	= 120
+CC			= gcc
+CFLAGS		= -std=c99 -D_POSIX_C_SOURCE=200809L -O2 -Wall -Wno-main
+LDLIBS		= -lrt
+RM			= rm -rf
+
+
+
+#---------------------------------------------------------------------------------#
+# TARGET FILES & DIRECTORIES: ----CHANGE THESE AS NEEDED----					  #
+#---------------------------------------------------------------------------------#
+# SRC_DIR: Directory of the kernel sources
+SRC_DIR		= code/src
+# INC_DIR: Directory of the header files
+INC_DIR		= code/include
+# BENCH_DIR: Directory of the benchmark sources
+BENCH_DIR	= bench
+# BUILD_DIR: Directory where the generated files will be placed
+BUILD_DIR	= build/bench
+
+# TASKS: Numbers of tasks to benchmark (1 to CUTEOS_CFG_MAX_TASKS)
+TASKS		= 1 2 4 8 16 24 32
+# MIXES: Periods mixes to benchmark (see bench_periods in bench/bench.c)
+MIXES		= 0 1 2
+# RUNS: Number of runs of task 0 in each configuration
+RUNS		= 50
+# DEFINES: Kernel configuration of the benchmark (see code/include/cuteOS_cfg.h)
+DEFINES		= -DCUTEOS_CFG_ISR_STATS=1 -DBENCH_RUNS=${RUNS}
+
+
+
+#---------------------------------------------------------------------------------#
+# GENERATION OF FILES: ----DO NOT CHANGE ANYTHING BELOW THIS LINE----			  #
+#---------------------------------------------------------------------------------#
+HEADER	= mix,tasks,tick_us,isr_entry_max,isr_max,isr_last,dispatch_min,dispatch_max,jitter_max,overruns
+
+# all : run the matrix on ucsim
+all	: ${BUILD_DIR}/ucsim.csv
+
+# ${BUILD_DIR}/ucsim.csv : for each configuration, compile the 3 modules, link,
+# find the address of BENCH_Exit in the map file, then run ucsim until it gets there.
+# The map lines are "C:   <address>  _BENCH_Exit  bench". The configuration fails
+# if the symbol is not found or if ucsim does not get there in UCSIM_TIMEOUT.
+# The UART output of the simulator is the CSV line of the configuration.
+${BUILD_DIR}/ucsim.csv : FORCE
+	@mkdir -p ${BUILD_DIR}/ucsim
+	@echo "${HEADER}" > $@
+	@for mix in ${MIXES}; do for tasks in ${TASKS}; do													\
+		out=${BUILD_DIR}/ucsim/bench_$${mix}_$${tasks};													\
+		mkdir -p $${out};																				\
+		for src in ${SRC_DIR}/cuteOS.c ${SRC_DIR}/hal_8051.c ${BENCH_DIR}/bench.c; do					\
+			${SDCC} ${SDCC_FLAGS} ${DEFINES} -DBENCH_MIX=$${mix} -DBENCH_TASKS=$${tasks}				\
+				-I${INC_DIR} -c -o $${out}/ $${src} || exit 1;											\
+		done;																							\
+		${SDCC} ${SDCC_FLAGS} -o $${out}/bench.ihx $${out}/bench.rel $${out}/cuteOS.rel $${out}/hal_8051.rel || exit 1; \
+		stop=`awk '$$3 == "_BENCH_Exit" { print $$2 }' $${out}/bench.map | head -n 1`;				\
+		if [ -z "$${stop}" ]; then																		\
+			echo "$${out}/bench.map: _BENCH_Exit not found"; exit 1;									\
+		fi;																								\
+		rm -f $${out}/uart.txt;																			\
+		printf 'break 0x%s\nrun\nquit\n' $${stop} |														\
+			${TIMEOUT} ${UCSIM_TIMEOUT} ${UCSIM} ${UCSIM_FLAGS} -S in=/dev/null,out=$${out}/uart.txt $${out}/bench.ihx > $${out}/ucsim.log; \
+		if [ ! -s $${out}/uart.txt ]; then																\
+			echo "$${out}: ucsim did not reach BENCH_Exit in ${UCSIM_TIMEOUT} s, see ucsim.log"; exit 1;	\
+		fi;																								\
+		cat $${out}/uart.txt >> $@;																		\
+	done; done
+	@cat $@
+
+# posix : run the matrix natively
+posix : FORCE
+	@mkdir -p ${BUILD_DIR}/posix
+	@echo "${HEADER}" > ${BUILD_DIR}/posix.csv
+	@for mix in ${MIXES}; do for tasks in ${TASKS}; do													\
+		${CC} ${CFLAGS} ${DEFINES} -DBENCH_MIX=$${mix} -DBENCH_TASKS=$${tasks} -I${INC_DIR}				\
+			-o ${BUILD_DIR}/posix/bench ${BENCH_DIR}/bench.c ${SRC_DIR}/cuteOS.c ${SRC_DIR}/hal_posix.c ${LDLIBS} || exit 1; \
+		${BUILD_DIR}/posix/bench >> ${BUILD_DIR}/posix.csv;												\
+	done; done
+	@cat ${BUILD_DIR}/posix.csv
+
+# clean : remove all generated files
+clean :
+	@-${RM} ${BUILD_DIR}
+
+# Phony targets: targets that are not really files, but are used to
+# control the build process.
+.PHONY	: clean all posix FORCE
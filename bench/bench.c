@@ -0,0 +1,268 @@
+/********************************************************************************
+ * @file    bench.c
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Scheduler benchmark: one configuration of tasks per build.
+ * @details The benchmark creates \ref BENCH_TASKS empty tasks with the
+ * 			periods of the mix \ref BENCH_MIX, lets them run until task 0 ran
+ * 			\ref BENCH_RUNS times, then prints one CSV line and stops.
+ * 			The measures are taken on the target with Timer 2 itself, so
+ * 			they are in instruction cycles on the 8051 (or on ucsim):
+ * 			- isr_entry_max: Longest delay from the Timer 2 overflow to the
+ * 			  ISR body (\ref cuteOS_GetIsrStats()).
+ * 			- isr_max, isr_last: Longest and last ISR body.
+ * 			- dispatch_min, dispatch_max: Delay from the Timer 2 overflow to
+ * 			  the start of task 0, the task of highest priority.
+ * 			- jitter_max: Largest (max - min) start delay of all the tasks,
+ * 			  the release jitter.
+ * 			- overruns: \ref cuteOS_GetOverruns().
+ *
+ * 			Build options (compiler defines):
+ * 			- \c BENCH_TASKS : Number of tasks, 1 to \ref CUTEOS_CFG_MAX_TASKS.
+ * 			- \c BENCH_MIX : Periods mix, see \ref bench_periods.
+ * 			- \c BENCH_RUNS : Number of runs of task 0.
+ *
+ * 			See \c bench.mk: the whole matrix is built with SDCC and run on
+ * 			the ucsim 8051 simulator, or built and run natively with the
+ * 			POSIX HAL (the values are then in microseconds of a 12 MHz
+ * 			8051, not cycle accurate).
+ * @note    The start delays are measured from the last Timer 2 overflow,
+ * 			so they are valid while the tasks of a tick end before the next
+ * 			tick (see the overruns column), and in the non-tickless mode.
+ * @version 1.0.0
+ * @date    2022-04-28
+ * @copyright Copyright (c) 2022
+ ********************************************************************************/
+#include "STD_TYPES.h"
+#include "main.h"
+#include "hal.h"
+#include "cuteOS_cfg.h"
+#include "cuteOS.h"
+
+#if defined(HAL_POSIX)
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+/*--------------------------------------------------------------------*/
+/*                          DEFINITIONS                               */
+/*--------------------------------------------------------------------*/
+#ifndef BENCH_TASKS
+#define BENCH_TASKS     8
+#endif
+
+#ifndef BENCH_MIX
+#define BENCH_MIX       1
+#endif
+
+#ifndef BENCH_RUNS
+#define BENCH_RUNS      50
+#endif
+
+#define BENCH_TASKS_MAX 32      /*!< Number of task functions */
+
+#if (BENCH_TASKS < 1) || (BENCH_TASKS > CUTEOS_CFG_MAX_TASKS) || (BENCH_TASKS > BENCH_TASKS_MAX)
+#error "BENCH_TASKS must be 1 to CUTEOS_CFG_MAX_TASKS (and BENCH_TASKS_MAX at most)"
+#endif
+
+#define BENCH_MIXES     3       /*!< Number of periods mixes */
+#define BENCH_MIX_LEN   8       /*!< Number of periods in a mix, the tasks use them in turn */
+
+
+/*--------------------------------------------------------------------*/
+/*                  PRIVATE FUNCTIONS DECLARATION                     */
+/*--------------------------------------------------------------------*/
+static ERROR_t BENCH_Probe(const u8_t index);
+static void BENCH_Report(void);
+static void BENCH_PutChar(const char c);
+static void BENCH_PutNumber(u32_t number);
+void BENCH_Exit(void);
+
+
+/*--------------------------------------------------------------------*/
+/*                          PRIVATE DATA                              */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @brief   Periods of the tasks in ms, task i uses bench_periods[BENCH_MIX][i % 8].
+ * @details - 0: Same period for all the tasks (all released in the same tick).
+ *          - 1: Harmonic periods (tick 10 ms).
+ *          - 2: Non harmonic periods (tick 5 ms).
+ *********************************************************************/
+static const u16_t HAL_CODE bench_periods[BENCH_MIXES][BENCH_MIX_LEN] = {
+    {10, 10, 10, 10, 10, 10, 10, 10},
+    {10, 20, 40, 80, 10, 20, 40, 80},
+    {10, 15, 20, 25, 30, 50, 60, 75}
+};
+
+/*!< Start delay of each task from the last Timer 2 overflow, in Timer 2 increments */
+static u16_t HAL_XDATA bench_delay_min[BENCH_TASKS_MAX];
+static u16_t HAL_XDATA bench_delay_max[BENCH_TASKS_MAX];
+
+static u16_t bench_reload = 0;      /*!< Timer 2 reload value of one tick, known once the scheduler started */
+static u16_t bench_runs = 0;        /*!< Number of runs of task 0 */
+
+
+/*--------------------------------------------------------------------*/
+/*                          TASKS                                     */
+/*--------------------------------------------------------------------*/
+/*!< One task function per task, so each run knows the index of its task for BENCH_Probe() */
+#define BENCH_TASK(N)   static ERROR_t BENCH_Task##N(void) { return BENCH_Probe(N); }
+
+BENCH_TASK(0)  BENCH_TASK(1)  BENCH_TASK(2)  BENCH_TASK(3)
+BENCH_TASK(4)  BENCH_TASK(5)  BENCH_TASK(6)  BENCH_TASK(7)
+BENCH_TASK(8)  BENCH_TASK(9)  BENCH_TASK(10) BENCH_TASK(11)
+BENCH_TASK(12) BENCH_TASK(13) BENCH_TASK(14) BENCH_TASK(15)
+BENCH_TASK(16) BENCH_TASK(17) BENCH_TASK(18) BENCH_TASK(19)
+BENCH_TASK(20) BENCH_TASK(21) BENCH_TASK(22) BENCH_TASK(23)
+BENCH_TASK(24) BENCH_TASK(25) BENCH_TASK(26) BENCH_TASK(27)
+BENCH_TASK(28) BENCH_TASK(29) BENCH_TASK(30) BENCH_TASK(31)
+
+static ERROR_t (* const HAL_CODE bench_tasks[BENCH_TASKS_MAX])(void) = {
+    BENCH_Task0,  BENCH_Task1,  BENCH_Task2,  BENCH_Task3,
+    BENCH_Task4,  BENCH_Task5,  BENCH_Task6,  BENCH_Task7,
+    BENCH_Task8,  BENCH_Task9,  BENCH_Task10, BENCH_Task11,
+    BENCH_Task12, BENCH_Task13, BENCH_Task14, BENCH_Task15,
+    BENCH_Task16, BENCH_Task17, BENCH_Task18, BENCH_Task19,
+    BENCH_Task20, BENCH_Task21, BENCH_Task22, BENCH_Task23,
+    BENCH_Task24, BENCH_Task25, BENCH_Task26, BENCH_Task27,
+    BENCH_Task28, BENCH_Task29, BENCH_Task30, BENCH_Task31
+};
+
+
+/*--------------------------------------------------------------------*/
+/*                          MAIN                                      */
+/*--------------------------------------------------------------------*/
+void main(void) {
+    u8_t i;
+
+#if defined(HAL_8051)
+    /*!< UART: mode 1, Timer 1 baud rate generator (TH1 0xFD: about 10400 baud at the 12 MHz of ucsim -X 12M, ucsim does not check the rate), ucsim prints it */
+    SCON = 0x50;
+    TMOD = (TMOD & 0x0F) | 0x20;
+    TH1 = 0xFD;
+    TR1 = 1;
+    TI = 1;
+#endif
+
+    cuteOS_Init();
+
+    for(i = 0; i < BENCH_TASKS; ++i) {
+        bench_delay_min[i] = 0xFFFF;
+        bench_delay_max[i] = 0;
+        cuteOS_TaskCreate(bench_tasks[i], CUTEOS_MS(bench_periods[BENCH_MIX][i % BENCH_MIX_LEN]),
+                          (0 == i) ? CUTEOS_PRIO_HIGHEST : CUTEOS_PRIO_AUTO, NULL);
+    }
+
+    cuteOS_Start();
+}
+
+
+/*--------------------------------------------------------------------*/
+/*                  PRIVATE FUNCTIONS DEFINITIONS                     */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @brief   Body of all the tasks: record the start delay of the task.
+ *********************************************************************/
+static ERROR_t BENCH_Probe(const u8_t index) {
+    u16_t delay = HAL_TimerRead();
+    u16_t tick_time;
+
+    if(0 == bench_reload) {
+        /*!< Timer 2 increments in one tick, as computed by the kernel */
+        cuteOS_GetTickTime(&tick_time);
+        bench_reload = HAL_TIMER_RELOAD( ((u32_t)tick_time * ((u32_t)CUTEOS_CFG_TIME_UNIT_US * (OSC_FREQ / 1000UL))) /
+                                         (1000UL * (u32_t)OSC_PER_INST) );
+    }
+    delay -= bench_reload;
+
+    if(delay < bench_delay_min[index]) {
+        bench_delay_min[index] = delay;
+    }
+    if(delay > bench_delay_max[index]) {
+        bench_delay_max[index] = delay;
+    }
+
+    if( (0 == index) && (++bench_runs >= BENCH_RUNS) ) {
+        BENCH_Report();
+        BENCH_Exit();
+    }
+
+    return ERROR_NO;
+}
+
+/**********************************************************************
+ * @brief   Print the results as one CSV line, see \ref bench.c for the columns:
+ *          mix,tasks,tick_us,isr_entry_max,isr_max,isr_last,dispatch_min,dispatch_max,jitter_max,overruns
+ *********************************************************************/
+static void BENCH_Report(void) {
+    cuteOS_ISR_STATS_t isr_stats;
+    u16_t jitter_max = 0;
+    u16_t overruns;
+    u16_t tick_time;
+    u8_t i;
+
+    cuteOS_GetIsrStats(&isr_stats);
+    cuteOS_GetOverruns(&overruns);
+    cuteOS_GetTickTime(&tick_time);
+
+    for(i = 0; i < BENCH_TASKS; ++i) {
+        if( (bench_delay_max[i] >= bench_delay_min[i]) &&
+            ((u16_t)(bench_delay_max[i] - bench_delay_min[i]) > jitter_max) ) {
+            jitter_max = bench_delay_max[i] - bench_delay_min[i];
+        }
+    }
+
+    BENCH_PutNumber(BENCH_MIX);                 BENCH_PutChar(',');
+    BENCH_PutNumber(BENCH_TASKS);               BENCH_PutChar(',');
+    BENCH_PutNumber((u32_t)tick_time * CUTEOS_CFG_TIME_UNIT_US); BENCH_PutChar(',');
+    BENCH_PutNumber(isr_stats.entry_cycles_max); BENCH_PutChar(',');
+    BENCH_PutNumber(isr_stats.cycles_max);      BENCH_PutChar(',');
+    BENCH_PutNumber(isr_stats.cycles_last);     BENCH_PutChar(',');
+    BENCH_PutNumber(bench_delay_min[0]);        BENCH_PutChar(',');
+    BENCH_PutNumber(bench_delay_max[0]);        BENCH_PutChar(',');
+    BENCH_PutNumber(jitter_max);                BENCH_PutChar(',');
+    BENCH_PutNumber(overruns);                  BENCH_PutChar('\n');
+}
+
+static void BENCH_PutChar(const char c) {
+#if defined(HAL_8051)
+    while(0 == TI) {
+    }
+    TI = 0;
+    SBUF = c;
+#else
+    putchar(c);
+#endif
+}
+
+static void BENCH_PutNumber(u32_t number) {
+    char digits[10];
+    u8_t i = 0;
+
+    do {
+        digits[i++] = (char)('0' + (number % 10));
+        number /= 10;
+    } while(number != 0);
+
+    while(i > 0) {
+        BENCH_PutChar(digits[--i]);
+    }
+}
+
+/**********************************************************************
+ * @brief   Stop the benchmark.
+ * @details On the 8051, the CPU loops in this function with the interrupts
+ *          disabled: \c bench.mk stops ucsim with a breakpoint on it (it
+ *          is not static, so its address is in the map file).
+ *********************************************************************/
+void BENCH_Exit(void) {
+#if defined(HAL_8051)
+    while(0 == TI) {        /*!< Let the last character go out */
+    }
+    HAL_INT_DISABLE();
+    while(1) {
+    }
+#else
+    fflush(stdout);
+    exit(EXIT_SUCCESS);
+#endif
+}
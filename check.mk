@@ -0,0 +1,64 @@
+###################################################################################
+# Author		: Mahmoud Karam Emara (ma.karam272@gmail.com)
+# Version		: 1.0.0
+# Date 			: 20 May 2022
+# Description	: makefile of the host checks (see check/):
+#					<make -f check.mk all>
+#					* Build every check natively with the POSIX HAL and run
+#					  it, stops at the first one that fails:
+#					  - ring_stress: a signal handler producer and a cuteOS
+#					    task consumer on one ring, checks the order of the
+#					    elements and the dropped count
+#					  - event_only: an event task without timeout is the only
+#					    task (no period, so a tick of 1 time unit)
+#				  Requires: gcc and make
+###################################################################################
+
+#---------------------------------------------------------------------------------#
+# TOOLS: ----CHANGE THESE AS NEEDED----											  #
+#---------------------------------------------------------------------------------#
+CC			= gcc
+CFLAGS		= -std=c99 -D_POSIX_C_SOURCE=200809L -O2 -Wall -Wno-main
+LDLIBS		= -lrt
+RM			= rm -rf
+
+
+
+#---------------------------------------------------------------------------------#
+# TARGET FILES & DIRECTORIES: ----CHANGE THESE AS NEEDED----					  #
+#---------------------------------------------------------------------------------#
+# SRC_DIR: Directory of the kernel sources
+SRC_DIR		= code/src
+# INC_DIR: Directory of the header files
+INC_DIR		= code/include
+# CHECK_DIR: Directory of the checks sources, one program per file
+CHECK_DIR	= check
+# BUILD_DIR: Directory where the generated files will be placed
+BUILD_DIR	= build/check
+
+# CHECKS: Checks to run (file names in CHECK_DIR, without .c)
+CHECKS		= ring_stress event_only
+# DEFINES: Kernel configuration of the checks (see code/include/cuteOS_cfg.h)
+DEFINES		=
+
+
+
+#---------------------------------------------------------------------------------#
+# GENERATION OF FILES: ----DO NOT CHANGE ANYTHING BELOW THIS LINE----			  #
+#---------------------------------------------------------------------------------#
+# all : build and run every check
+all	: FORCE
+	@mkdir -p ${BUILD_DIR}
+	@for check in ${CHECKS}; do																			\
+		${CC} ${CFLAGS} ${DEFINES} -I${INC_DIR} -o ${BUILD_DIR}/$${check}								\
+			${CHECK_DIR}/$${check}.c ${SRC_DIR}/cuteOS.c ${SRC_DIR}/hal_posix.c ${LDLIBS} || exit 1;	\
+		${BUILD_DIR}/$${check} || exit 1;																\
+	done
+
+# clean : remove all generated files
+clean :
+	@-${RM} ${BUILD_DIR}
+
+# Phony targets: targets that are not really files, but are used to
+# control the build process.
+.PHONY	: clean all FORCE
@@ -0,0 +1,140 @@
+/********************************************************************************
+ * @file    event_only.c
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Host check of a task set with only an event task without
+ * 			timeout, on the POSIX HAL.
+ * @details No task has a period, so the GCD of the periods is 0 and the
+ * 			tick time falls back to 1 time unit. The ISR of INT0 (\c SIGUSR1
+ * 			on the POSIX HAL), raised by a POSIX timer every
+ * 			\ref EVENT_PRODUCER_MS, sets the event of the task.
+ *
+ * 			The check fails if \ref cuteOS_Start() crashes (a division by
+ * 			the GCD of the periods), or if the task did not run
+ * 			\ref EVENT_RUNS times within \ref EVENT_TIMEOUT interrupts.
+ *
+ * 			Prints one line, exits with 0 on success and 1 on failure. See
+ * 			\c check.mk.
+ * @version 1.0.0
+ * @date    2022-05-20
+ * @copyright Copyright (c) 2022
+ ********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include "STD_TYPES.h"
+#include "main.h"
+#include "hal.h"
+#include "cuteOS_cfg.h"
+#include "cuteOS.h"
+
+#if !defined(HAL_POSIX)
+#error "event_only.c is a host check, build it with the POSIX HAL"
+#endif
+
+#if !CUTEOS_CFG_EVENTS
+#error "event_only.c needs CUTEOS_CFG_EVENTS"
+#endif
+
+/*--------------------------------------------------------------------*/
+/*                          DEFINITIONS                               */
+/*--------------------------------------------------------------------*/
+#define EVENT_TICK          0x01    /*!< The event of the task */
+#define EVENT_PRODUCER_MS   2       /*!< Period of the interrupt setting the event */
+#define EVENT_RUNS          50      /*!< Runs of the task to pass */
+#define EVENT_TIMEOUT       1000    /*!< Interrupts to fail */
+
+
+/*--------------------------------------------------------------------*/
+/*                  PRIVATE FUNCTIONS DECLARATION                     */
+/*--------------------------------------------------------------------*/
+static ERROR_t EVENT_Task(void);
+static void EVENT_ProducerStart(void);
+static void EVENT_Exit(const BOOL_t passed);
+
+
+/*--------------------------------------------------------------------*/
+/*                          PRIVATE DATA                              */
+/*--------------------------------------------------------------------*/
+static volatile u16_t event_raised = 0;     /*!< Interrupts, written by the ISR only */
+static u16_t event_runs = 0;                /*!< Runs of the task */
+
+
+/*--------------------------------------------------------------------*/
+/*                          ISR                                       */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @brief   Release the event task, or give up after \ref EVENT_TIMEOUT.
+ *********************************************************************/
+HAL_EXT_ISR(EVENT_Producer, 0) {
+    if(++event_raised >= EVENT_TIMEOUT) {
+        printf("event_only: timeout, runs=%u\n", (unsigned)event_runs);
+        EVENT_Exit(FALSE);
+    }
+    cuteOS_EventSet(EVENT_TICK);
+}
+
+
+/*--------------------------------------------------------------------*/
+/*                          MAIN                                      */
+/*--------------------------------------------------------------------*/
+void main(void) {
+    ERROR_t error = ERROR_NO;
+
+    cuteOS_Init();
+
+    error |= cuteOS_EventTaskCreate(EVENT_Task, EVENT_TICK, 0, 0, NULL);
+    if(ERROR_NO != error) {
+        printf("event_only: cannot create the task\n");
+        EVENT_Exit(FALSE);
+    }
+    HAL_ExtIntEnable(0, EVENT_Producer);
+    EVENT_ProducerStart();
+
+    cuteOS_Start();
+}
+
+
+/*--------------------------------------------------------------------*/
+/*                  PRIVATE FUNCTIONS DEFINITIONS                     */
+/*--------------------------------------------------------------------*/
+static ERROR_t EVENT_Task(void) {
+    u16_t tick_time;
+
+    if(++event_runs >= EVENT_RUNS) {
+        cuteOS_GetTickTime(&tick_time);
+        printf("event_only: runs=%u interrupts=%u tick=%u\n",
+               (unsigned)event_runs, (unsigned)event_raised, (unsigned)tick_time);
+        EVENT_Exit(TRUE);
+    }
+
+    return ERROR_NO;
+}
+
+/**********************************************************************
+ * @brief   Start the POSIX timer that raises INT0 (SIGUSR1) periodically.
+ *********************************************************************/
+static void EVENT_ProducerStart(void) {
+    timer_t timer_id;
+    struct sigevent event;
+    struct itimerspec spec;
+
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGUSR1;
+    event.sigev_value.sival_ptr = NULL;
+    spec.it_value.tv_sec = 0;
+    spec.it_value.tv_nsec = EVENT_PRODUCER_MS * 1000000L;
+    spec.it_interval = spec.it_value;
+
+    if( (0 != timer_create(CLOCK_MONOTONIC, &event, &timer_id)) ||
+        (0 != timer_settime(timer_id, 0, &spec, NULL)) ) {
+        printf("event_only: cannot start the producer\n");
+        EVENT_Exit(FALSE);
+    }
+}
+
+static void EVENT_Exit(const BOOL_t passed) {
+    printf("event_only: %s\n", (TRUE == passed) ? "PASS" : "FAIL");
+    fflush(stdout);
+    exit((TRUE == passed) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,192 @@
+/********************************************************************************
+ * @file    ring_stress.c
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Stress check of the ring buffer (\ref ring.h) on the POSIX HAL:
+ * 			a signal handler produces, a cuteOS task consumes.
+ * @details The producer is the ISR of INT0 (\c SIGUSR1 on the POSIX HAL),
+ * 			raised by a POSIX timer every \ref STRESS_PRODUCER_US. Every
+ * 			interrupt puts the next number of a sequence, until
+ * 			\ref STRESS_PUTS numbers were put or dropped. The consumer is a
+ * 			1 ms task that gets all the elements, except for
+ * 			\ref STRESS_PAUSE_RUNS runs every \ref STRESS_PAUSE_EVERY runs,
+ * 			so the ring fills up and the producer drops elements.
+ *
+ * 			The producer interrupts the consumer at any point of
+ * 			\ref RING_GET(), so the check fails if:
+ * 			- An element comes out of order (or twice).
+ * 			- The elements missing from the sequence are not exactly the
+ * 			  ones the producer dropped (\ref ERROR_BUSY).
+ * 			- \ref RING_DROPPED() is not the number of dropped elements
+ * 			  (saturated at 255).
+ * 			- Nothing was dropped (the full ring was not exercised), or the
+ * 			  producer did not finish within \ref STRESS_TIMEOUT_MS.
+ *
+ * 			Prints one line with the counters, exits with 0 on success and
+ * 			1 on failure. See \c check.mk.
+ * @version 1.0.0
+ * @date    2022-05-20
+ * @copyright Copyright (c) 2022
+ ********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include "STD_TYPES.h"
+#include "main.h"
+#include "hal.h"
+#include "cuteOS_cfg.h"
+#include "cuteOS.h"
+#include "ring.h"
+
+#if !defined(HAL_POSIX)
+#error "ring_stress.c is a host check, build it with the POSIX HAL"
+#endif
+
+/*--------------------------------------------------------------------*/
+/*                          DEFINITIONS                               */
+/*--------------------------------------------------------------------*/
+#define STRESS_RING_SIZE    32          /*!< Elements in the ring */
+#define STRESS_PUTS         20000U      /*!< Elements put or dropped by the producer */
+#define STRESS_PRODUCER_US  50          /*!< Period of the producer interrupt */
+#define STRESS_PAUSE_EVERY  200         /*!< The consumer pauses every this number of runs... */
+#define STRESS_PAUSE_RUNS   3           /*!< ...for this number of runs */
+#define STRESS_TIMEOUT_MS   10000UL     /*!< The producer must be done by then */
+
+
+/*--------------------------------------------------------------------*/
+/*                  PRIVATE FUNCTIONS DECLARATION                     */
+/*--------------------------------------------------------------------*/
+static ERROR_t STRESS_Consumer(void);
+static void STRESS_ProducerStart(void);
+static void STRESS_Exit(const BOOL_t passed);
+
+
+/*--------------------------------------------------------------------*/
+/*                          PRIVATE DATA                              */
+/*--------------------------------------------------------------------*/
+static RING_DECLARE(stress_ring, u16_t, STRESS_RING_SIZE);
+
+/*!< Written by the producer only */
+static volatile u16_t stress_puts = 0;      /*!< Numbers put or dropped, the next one to put */
+static volatile u16_t stress_busy = 0;      /*!< Numbers dropped (ERROR_BUSY) */
+
+/*!< Written by the consumer only */
+static u16_t stress_next = 0;               /*!< Next number expected */
+static u16_t stress_got = 0;                /*!< Numbers got */
+static u16_t stress_lost = 0;               /*!< Numbers missing from the sequence */
+static u16_t stress_disorders = 0;          /*!< Numbers got out of order */
+static u32_t stress_runs = 0;               /*!< Runs of the consumer */
+
+
+/*--------------------------------------------------------------------*/
+/*                          ISR                                       */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @brief   Producer: put the next number of the sequence.
+ *********************************************************************/
+HAL_EXT_ISR(STRESS_Producer, 0) {
+    ERROR_t error = ERROR_NO;
+
+    if(stress_puts < STRESS_PUTS) {
+        RING_PUT(stress_ring, stress_puts, error);
+        if(ERROR_NO != error) {
+            ++stress_busy;
+        }
+        ++stress_puts;
+    }
+}
+
+
+/*--------------------------------------------------------------------*/
+/*                          MAIN                                      */
+/*--------------------------------------------------------------------*/
+void main(void) {
+    cuteOS_Init();
+
+    RING_RESET(stress_ring);
+    cuteOS_TaskCreate(STRESS_Consumer, CUTEOS_MS(1), CUTEOS_PRIO_AUTO, NULL);
+    HAL_ExtIntEnable(0, STRESS_Producer);
+    STRESS_ProducerStart();
+
+    cuteOS_Start();
+}
+
+
+/*--------------------------------------------------------------------*/
+/*                  PRIVATE FUNCTIONS DEFINITIONS                     */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @brief   Consumer: get the elements and check the sequence, then check
+ *          the counters once the producer is done and the ring is empty.
+ *********************************************************************/
+static ERROR_t STRESS_Consumer(void) {
+    u16_t value;
+    u8_t dropped;
+    BOOL_t done;
+
+    ++stress_runs;
+    done = (STRESS_PUTS == stress_puts) ? TRUE : FALSE;    /*!< Read before the ring: nothing is put after it */
+
+    if( (FALSE == done) && ((stress_runs % STRESS_PAUSE_EVERY) < STRESS_PAUSE_RUNS) ) {
+        return ERROR_NO;        /*!< Let the ring fill up */
+    }
+
+    while(!RING_IS_EMPTY(stress_ring)) {
+        RING_GET(stress_ring, value);
+        if(value < stress_next) {
+            ++stress_disorders;
+        } else {
+            stress_lost += (u16_t)(value - stress_next);
+            stress_next = (u16_t)(value + 1);
+        }
+        ++stress_got;
+    }
+
+    if(TRUE == done) {
+        stress_lost += (u16_t)(STRESS_PUTS - stress_next);     /*!< Dropped after the last element got */
+        dropped = RING_DROPPED(stress_ring);
+
+        printf("ring_stress: puts=%u got=%u busy=%u lost=%u dropped=%u disorders=%u\n",
+               (unsigned)stress_puts, (unsigned)stress_got, (unsigned)stress_busy,
+               (unsigned)stress_lost, (unsigned)dropped, (unsigned)stress_disorders);
+
+        STRESS_Exit( ( (0 == stress_disorders) &&
+                       (stress_lost == stress_busy) &&
+                       ((u16_t)(stress_got + stress_lost) == STRESS_PUTS) &&
+                       (dropped == ((stress_busy > 0xFF) ? 0xFF : stress_busy)) &&
+                       (stress_busy > 0) ) ? TRUE : FALSE );
+    } else if(stress_runs >= STRESS_TIMEOUT_MS) {
+        printf("ring_stress: timeout, puts=%u\n", (unsigned)stress_puts);
+        STRESS_Exit(FALSE);
+    }
+
+    return ERROR_NO;
+}
+
+/**********************************************************************
+ * @brief   Start the POSIX timer that raises INT0 (SIGUSR1) periodically.
+ *********************************************************************/
+static void STRESS_ProducerStart(void) {
+    timer_t timer_id;
+    struct sigevent event;
+    struct itimerspec spec;
+
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGUSR1;
+    event.sigev_value.sival_ptr = NULL;
+    spec.it_value.tv_sec = 0;
+    spec.it_value.tv_nsec = STRESS_PRODUCER_US * 1000L;
+    spec.it_interval = spec.it_value;
+
+    if( (0 != timer_create(CLOCK_MONOTONIC, &event, &timer_id)) ||
+        (0 != timer_settime(timer_id, 0, &spec, NULL)) ) {
+        printf("ring_stress: cannot start the producer\n");
+        STRESS_Exit(FALSE);
+    }
+}
+
+static void STRESS_Exit(const BOOL_t passed) {
+    printf("ring_stress: %s\n", (TRUE == passed) ? "PASS" : "FAIL");
+    fflush(stdout);
+    exit((TRUE == passed) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -9,12 +9,20 @@
 #define STD_TYPES_H
 
 /* Signed integers	*/
+#if defined(__C51__) || defined(__SDCC)
 typedef     signed long int   	        s32_t;		
+#else
+typedef     signed int   	            s32_t;
+#endif
 typedef     signed short int 	        s16_t;		
 typedef     signed char                 s8_t;
   
 /* Unsigned integers	*/
+#if defined(__C51__) || defined(__SDCC)
 typedef 	unsigned long int	        u32_t;
+#else
+typedef 	unsigned int	            u32_t;      /*!< long is 64-bit on 64-bit hosts */
+#endif
 typedef 	unsigned short int          u16_t;
 typedef 	unsigned char 		        u8_t;
 
@@ -23,8 +31,10 @@ typedef 	float 				        f32;
 typedef 	double 				        f64;
 
 /* Special types	*/        
+#if defined(__C51__)
  #undef __SIZE_TYPE__       /*!< This macro is defined in <stddef.h> for the size_t type */   
 typedef 	u16_t   size_t;  
+#endif
 
 #undef HIGH
 #undef LOW
@@ -9,44 +9,662 @@
 #ifndef CUTE_OS_H
 #define CUTE_OS_H
 
+/*--------------------------------------------------------------------*/
+/*                          DEFINITIONS                               */
+/*--------------------------------------------------------------------*/
+#define CUTEOS_PRIO_LEVELS      8       /*!< Number of task priorities */
+#define CUTEOS_PRIO_HIGHEST     0       /*!< Highest task priority */
+#define CUTEOS_PRIO_LOWEST      7       /*!< Lowest task priority */
+
+/**********************************************************************
+ * @brief   Rate-monotonic priority: assigned from the period of the task,
+ *          the shorter the period the higher the priority.
+ *********************************************************************/
+#define CUTEOS_PRIO_AUTO        0xFF
+
+/**********************************************************************
+ * @brief   Automatic release offset, chosen to spread the tasks over the
+ *          ticks. See \ref cuteOS_TaskCreateOffset().
+ *********************************************************************/
+#define CUTEOS_OFFSET_AUTO      0xFFFFFFFFUL
+
+/**********************************************************************
+ * @brief   Convert a time in ms to time units (\ref CUTEOS_CFG_TIME_UNIT_US).
+ * @details All the times given to the kernel (periods, offsets, timeouts,
+ *          durations) and the tick time are in time units: 1 ms by
+ *          default, so these macros only matter when the time unit is
+ *          below 1 ms.
+ * @par Example
+ *      @code cuteOS_TaskCreate(control_loop, CUTEOS_US(250), 0, NULL); // every 250 us, with a time unit that divides 250 us @endcode
+ *      @code cuteOS_TaskCreate(led_blink, CUTEOS_MS(500), CUTEOS_PRIO_AUTO, NULL); // every 500 ms, any unit @endcode
+ *********************************************************************/
+#define CUTEOS_MS(MS)           ( (u32_t)(MS) * (1000UL / CUTEOS_CFG_TIME_UNIT_US) )
+
+/*!< Convert a time in us to time units, rounded down (see \ref CUTEOS_MS()). */
+#define CUTEOS_US(US)           ( (u32_t)(US) / CUTEOS_CFG_TIME_UNIT_US )
+
+/*!< Longest tick time in time units without the 65535 cap, see \ref CUTEOS_MAX_TICK_TIME. */
+#define CUTEOS_MAX_TICK_TIME_RAW    ( (65535UL * 1000UL * (u32_t)OSC_PER_INST) / ((u32_t)CUTEOS_CFG_TIME_UNIT_US * (OSC_FREQ / 1000UL)) )
+
+/**********************************************************************
+ * @brief   Maximum tick time in time units (\ref CUTEOS_CFG_TIME_UNIT_US).
+ * @details The tick time is at most one Timer 2 period, 65535 increments
+ *          (16-bit timer), and at most 65535 units (16-bit tick time).
+ *          With a 12 MHz clock and 12 clock cycles per instruction, Timer 2
+ *          counts 1 increment per us, so the maximum tick time is 65 ms:
+ *          65 with the default ms unit, 65535 with a 1 us unit. The kernel
+ *          and the analyzer (analyzer.mk) check the tick time against it.
+ *********************************************************************/
+#define CUTEOS_MAX_TICK_TIME    ( (CUTEOS_MAX_TICK_TIME_RAW > 65535UL) ? 65535UL : CUTEOS_MAX_TICK_TIME_RAW )
+
+/**********************************************************************
+ * @brief   The Timer 2 ISR runs on the register bank \ref CUTEOS_CFG_ISR_BANK:
+ *          in hybrid mode, and with a time unit below 1 ms.
+ *********************************************************************/
+#define CUTEOS_ISR_BANKED       ( CUTEOS_CFG_HYBRID || (CUTEOS_CFG_TIME_UNIT_US < 1000) )
+
+/**********************************************************************
+ * @brief   Handle of a task, given by the task creation functions.
+ * @details It identifies the task in \ref cuteOS_TaskRemove(),
+ *          \ref cuteOS_TaskSuspend() and \ref cuteOS_TaskResume(), even
+ *          when several tasks share the same function. It is the index of
+ *          the task in the tasks array (with the static task set, the
+ *          order of the task in \ref CUTEOS_CFG_STATIC_TASKS). It is not
+ *          valid after the task is removed: a new task may get it.
+ *********************************************************************/
+typedef u8_t cuteOS_TASK_HANDLE_t;
+
+#define CUTEOS_TASK_INVALID     0xFF    /*!< Handle given when the task is not created */
+
+/**********************************************************************
+ * @brief   Modes of the software timers, see \ref cuteOS_TimerStart().
+ *********************************************************************/
+#define CUTEOS_TIMER_ONE_SHOT       0   /*!< The callback runs once, then the timer stops */
+#define CUTEOS_TIMER_AUTO_RELOAD    1   /*!< The callback runs every duration until the timer is stopped */
+
+/**********************************************************************
+ * @brief   Execution time statistics of a task, see \ref cuteOS_GetTaskStats().
+ * @details The times are in instruction cycles (Timer 2 increments),
+ *          1 us with a 12 MHz crystal and 12 oscillations per instruction.
+ *********************************************************************/
+typedef struct {
+    u32_t min_cycles;   /*!< Shortest run */
+    u32_t max_cycles;   /*!< Longest run, the measured WCET */
+    u32_t avg_cycles;   /*!< Running average (exponential, weight 1/8) */
+    u16_t runs;         /*!< Number of measured runs (saturates at 65535) */
+}cuteOS_TASK_STATS_t;
+
+/**********************************************************************
+ * @brief   Execution time of the Timer 2 ISR, see \ref cuteOS_GetIsrStats().
+ * @details The times are in instruction cycles (Timer 2 increments). They
+ *          are measured from the first to the last statement of the ISR,
+ *          the register saving and restoring of the compiler are not
+ *          included.
+ *********************************************************************/
+typedef struct {
+    u16_t entry_cycles_max; /*!< Longest delay from the overflow to the ISR body */
+    u16_t cycles_last;      /*!< Duration of the last ISR */
+    u16_t cycles_max;       /*!< Longest ISR */
+}cuteOS_ISR_STATS_t;
+
+/**********************************************************************
+ * @brief   Types of the trace events (\ref CUTEOS_CFG_TRACE).
+ * @details Each event of a dump is 4 bytes: the type, an argument and
+ *          the low 16 bits of the time in Timer 2 increments (little
+ *          endian). See \ref cuteOS_TraceDump() for the dump format.
+ *********************************************************************/
+#define CUTEOS_TRACE_TICK           0x01    /*!< Timer 2 ISR, argument: ticks elapsed */
+#define CUTEOS_TRACE_TASK_START     0x02    /*!< Argument: task handle */
+#define CUTEOS_TRACE_TASK_END       0x03    /*!< Argument: task handle */
+#define CUTEOS_TRACE_TASK_CREATE    0x04    /*!< Argument: task handle */
+#define CUTEOS_TRACE_TASK_REMOVE    0x05    /*!< Argument: task handle */
+#define CUTEOS_TRACE_OVERRUN        0x06    /*!< Argument: task handle */
+#define CUTEOS_TRACE_TIMER_START    0x07    /*!< Argument: timer index */
+#define CUTEOS_TRACE_TIMER_END      0x08    /*!< Argument: timer index */
+
+/**********************************************************************
+ * @brief   CPU load statistics, see \ref cuteOS_GetLoadStats().
+ * @details The loads are the busy share of a window of
+ *          \ref CUTEOS_CFG_LOAD_WINDOW_MS, in per mille (0 to 1000).
+ *********************************************************************/
+typedef struct {
+    u16_t load_last;    /*!< Load of the last window */
+    u16_t load_peak;    /*!< Load of the busiest window */
+    u16_t load_avg;     /*!< Running average (exponential, weight 1/8) */
+    u16_t windows;      /*!< Number of measured windows (saturates at 65535) */
+    u32_t idle_entries; /*!< Number of times the CPU entered idle mode */
+}cuteOS_LOAD_STATS_t;
+
+
+/*--------------------------------------------------------------------*/
+/*                          API FUNCTIONS                             */
+/*--------------------------------------------------------------------*/
+
 /***************************************************************************
  * @brief   Sets up Timer 2 to drive the simple EOS.
  ***************************************************************************/
 ERROR_t cuteOS_Init(void);
 
 /**********************************************************************
- * @brief Create a task with the given task function and the given tick time.
+ * @brief Create a task with the given task function, period and priority.
  * @param[in] \c task_ptr: Pointer to the task function.
- * @param[in] \c TICK_TIME_MS: the frequency of task execution in milliseconds.
+ * @param[in] \c PERIOD: the period of task execution in time units (ms by default)
+ *            (32-bit, so periods longer than 65535 ms are allowed).
+ * @param[in] \c PRIORITY: \ref CUTEOS_PRIO_HIGHEST (0) to \ref CUTEOS_PRIO_LOWEST (7),
+ *            or \ref CUTEOS_PRIO_AUTO for a rate-monotonic priority.
+ *            When several tasks are due, the task of highest priority runs first.
+ * @param[out] \c ptr_handle: Pointer to the handle of the task (\ref CUTEOS_TASK_INVALID
+ *             if it is not created), or NULL if not needed.
  * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
  * @par Example
- *      @code cuteOS_TaskCreate(task1, 1000); // task1 will run every 1 second @endcode
- *      @code cuteOS_TaskCreate(task2, 2000); // task2 will run every 2 seconds @endcode
- *          
+ *      @code cuteOS_TaskCreate(task1, CUTEOS_MS(1000), 0, NULL); // task1 will run every 1 second, with the highest priority @endcode
+ *      @code cuteOS_TaskCreate(task2, CUTEOS_MS(2000), CUTEOS_PRIO_AUTO, &task2_handle); // task2 will run every 2 seconds @endcode
+ * @note    Not available with the static task set (\ref CUTEOS_CFG_STATIC),
+ *          the tasks are listed in \ref cuteOS_tasks_cfg.h.
+ *          After \ref cuteOS_Start(), the task is released at once on the
+ *          schedule of the other tasks. If the tick time does not divide
+ *          the period, it is reduced (see \ref cuteOS_TaskSetPeriod()).
  *********************************************************************/
-ERROR_t cuteOS_TaskCreate(ERROR_t (* const task_ptr)(void), const u16_t TICK_TIME_MS);
+ERROR_t cuteOS_TaskCreate(ERROR_t (* const task_ptr)(void), const u32_t PERIOD, const u8_t PRIORITY, cuteOS_TASK_HANDLE_t * const ptr_handle);
 
 /**********************************************************************
- * @brief Remove a task from the tasks array.
+ * @brief Create a task with a release offset.
+ * @details Like \ref cuteOS_TaskCreate(), but the task is released at
+ *          OFFSET, OFFSET + PERIOD, OFFSET + 2 * PERIOD, ...
+ *          from the start of the scheduler (an offset of 0 is the same as
+ *          PERIOD). Tasks of harmonic periods with different offsets
+ *          are not released in the same tick, so the worst-case work of a
+ *          tick is reduced. Non-zero offsets are included in the tick
+ *          time computation.
  * @param[in] \c task_ptr: Pointer to the task function.
+ * @param[in] \c PERIOD: the period of task execution in time units (ms by default).
+ * @param[in] \c PRIORITY: See \ref cuteOS_TaskCreate().
+ * @param[in] \c OFFSET: 0 to PERIOD - 1, or \ref CUTEOS_OFFSET_AUTO
+ *            to let the scheduler choose it (with \ref CUTEOS_CFG_BALANCE,
+ *            0 otherwise).
+ * @param[out] \c ptr_handle: See \ref cuteOS_TaskCreate().
  * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
  * @par Example
- *      @code cuteOS_TaskRemove(task1);       // remove task1 @endcode
- *      @code cuteOS_TaskRemove(task2);       // remove task2 @endcode
+ *      @code cuteOS_TaskCreateOffset(task1, CUTEOS_MS(1000), CUTEOS_PRIO_AUTO, CUTEOS_MS(500), NULL); // task1 will run at 0.5 s, 1.5 s, 2.5 s, ... @endcode
  *********************************************************************/
-ERROR_t cuteOS_TaskRemove(ERROR_t (* const task_ptr)(void));
+ERROR_t cuteOS_TaskCreateOffset(ERROR_t (* const task_ptr)(void), const u32_t PERIOD, const u8_t PRIORITY, const u32_t OFFSET, cuteOS_TASK_HANDLE_t * const ptr_handle);
 
+/**********************************************************************
+ * @brief Create a task with a worst-case execution time budget
+ *        (\ref CUTEOS_CFG_ADMISSION).
+ * @details Like \ref cuteOS_TaskCreateOffset(), but the task declares
+ *          the longest time a run of it takes, and it is refused if the
+ *          task set would be overloaded. The tasks with a budget are
+ *          checked at each task creation or period change (a task without
+ *          a budget can still reduce the tick time):
+ *          - Utilization: the sum of budget / period must not exceed 1.
+ *          - Worst tick: the budgets of the tasks that can be released in
+ *            the same tick must fit in the tick time, so the work of a
+ *            tick ends before the next tick. Two tasks can be released in
+ *            the same tick unless their offsets differ modulo the GCD of
+ *            their periods (an automatic offset is not known yet, so it
+ *            is assumed to meet the others).
+ *          The worst tick check adds, for each task, the budgets of all
+ *          the tasks it can meet: it never admits an overloaded tick, but
+ *          with offsets it may refuse tasks that never all meet at once.
+ *          The time of the Timer 2 ISR and of the software timers is not
+ *          included: keep a margin in the budgets.
+ * @param[in] \c task_ptr: Pointer to the task function.
+ * @param[in] \c PERIOD: See \ref cuteOS_TaskCreate().
+ * @param[in] \c PRIORITY: See \ref cuteOS_TaskCreate().
+ * @param[in] \c OFFSET: See \ref cuteOS_TaskCreateOffset().
+ * @param[in] \c WCET_US: Worst-case execution time in us, 0: no budget
+ *            (the task is not checked).
+ * @param[out] \c ptr_handle: See \ref cuteOS_TaskCreate().
+ * @return  \c ERROR_t: \ref ERROR_BUSY if the task is refused, see also
+ *          \ref cuteOS_TaskCreate().
+ * @par Example
+ *      @code cuteOS_TaskCreateBudget(task1, CUTEOS_MS(100), CUTEOS_PRIO_AUTO, 0, 1500, NULL); // Runs every 100 ms for 1.5 ms at most @endcode
+ * @note    Takes time proportional to the square of the number of tasks
+ *          with a budget.
+ *********************************************************************/
+ERROR_t cuteOS_TaskCreateBudget(ERROR_t (* const task_ptr)(void), const u32_t PERIOD, const u8_t PRIORITY, const u32_t OFFSET, const u16_t WCET_US, cuteOS_TASK_HANDLE_t * const ptr_handle);
+
+/**********************************************************************
+ * @brief Create a task run by events (\ref CUTEOS_CFG_EVENTS).
+ * @details The task does not run periodically: it runs at the next
+ *          dispatch after one of its events is set by \ref cuteOS_EventSet().
+ *          Several events set before it runs release it once. With a
+ *          timeout, it also runs when none of its events was set for
+ *          \c TIMEOUT (counted from the last event, or the start),
+ *          and every \c TIMEOUT after that until an event is set.
+ *          The task calls \ref cuteOS_EventGet() to know which events
+ *          released it (none for a timeout).
+ * @param[in] \c task_ptr: Pointer to the task function.
+ * @param[in] \c EVENTS: Mask of the events (bits 0 to 7) the task waits on.
+ * @param[in] \c TIMEOUT: Timeout in time units (ms by default), 0 to wait forever.
+ *            Like a period, it is included in the tick time computation.
+ * @param[in] \c PRIORITY: \ref CUTEOS_PRIO_HIGHEST (0) to \ref CUTEOS_PRIO_LOWEST (7).
+ *            \ref CUTEOS_PRIO_AUTO is not allowed, the task has no period.
+ * @param[out] \c ptr_handle: See \ref cuteOS_TaskCreate().
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ * @note    Not available with the static task set (\ref CUTEOS_CFG_STATIC).
+ *          Removed by \ref cuteOS_TaskRemove().
+ * @par Example
+ *      @code
+ *      #define EVENT_RX    0x01
+ *      cuteOS_EventTaskCreate(uart_rx, EVENT_RX, CUTEOS_MS(1000), 0, NULL);  // uart_rx runs when EVENT_RX is set, or after 1 s without it
+ *      @endcode
+ *********************************************************************/
+ERROR_t cuteOS_EventTaskCreate(ERROR_t (* const task_ptr)(void), const u8_t EVENTS, const u32_t TIMEOUT, const u8_t PRIORITY, cuteOS_TASK_HANDLE_t * const ptr_handle);
+
+/**********************************************************************
+ * @brief Set events (\ref CUTEOS_CFG_EVENTS).
+ * @details Every task waiting on one of the events is made ready, and
+ *          its timeout starts again. The events are not kept: a task
+ *          created later is not released by them.
+ *          The work depends on the number of event tasks, not on the
+ *          number of tasks, and the interrupts are disabled meanwhile.
+ * @param[in] \c EVENTS: Mask of the events (bits 0 to 7).
+ * @note    May be called from an ISR or a task, with the interrupts
+ *          enabled or not: they are restored as they were on return. The
+ *          function is reentrant (\ref HAL_REENTRANT), so an ISR calling it
+ *          while a task is in it does not overwrite the events of the task.
+ * @par Example
+ *      @code
+ *      void UART_ISR(void) interrupt 4 {
+ *          RING_PUT(rxRing, SBUF, error);
+ *          RI = 0;
+ *          cuteOS_EventSet(EVENT_RX);  // uart_rx runs at the next dispatch
+ *      }
+ *      @endcode
+ *********************************************************************/
+void cuteOS_EventSet(const u8_t EVENTS) HAL_REENTRANT;
+
+/**********************************************************************
+ * @brief Get the events that released the running event task.
+ * @param[out] \c ptr_events: Pointer to the mask of the events, 0 if the
+ *             task was released by its timeout.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ * @note    To be called from the event task.
+ *********************************************************************/
+ERROR_t cuteOS_EventGet(u8_t * const ptr_events);
+
+/**********************************************************************
+ * @brief Remove a task from the tasks array.
+ * @details Constant time. The other tasks keep their releases and the
+ *          tick time does not change. A pending release of the task is
+ *          dropped.
+ * @param[in] \c HANDLE: Handle of the task.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_YES if the handle is not a task.
+ * @par Example
+ *      @code cuteOS_TaskRemove(task1_handle);       // remove task1 @endcode
+ *********************************************************************/
+ERROR_t cuteOS_TaskRemove(const cuteOS_TASK_HANDLE_t HANDLE);
+
+/**********************************************************************
+ * @brief Stop releasing a task until \ref cuteOS_TaskResume().
+ * @details Constant time, like \ref cuteOS_TaskRemove(), but the task
+ *          keeps its slot and its phase. A pending release of the task is
+ *          dropped, and an event task ignores its events meanwhile.
+ * @param[in] \c HANDLE: Handle of the task.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_YES if the handle is not a task.
+ *********************************************************************/
+ERROR_t cuteOS_TaskSuspend(const cuteOS_TASK_HANDLE_t HANDLE);
+
+/**********************************************************************
+ * @brief Release a suspended task again.
+ * @details The task is released at the next tick of its original
+ *          schedule (its offset plus whole periods), as if it had never
+ *          been suspended. An event task waits for its events, its
+ *          timeout starts again. Resuming a running task does nothing.
+ * @param[in] \c HANDLE: Handle of the task.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_YES if the handle is not a task.
+ * @par Example
+ *      @code
+ *      cuteOS_TaskSuspend(buzzer_handle);      // Feature off
+ *      ...
+ *      cuteOS_TaskResume(buzzer_handle);       // Feature on, same phase as before
+ *      @endcode
+ *********************************************************************/
+ERROR_t cuteOS_TaskResume(const cuteOS_TASK_HANDLE_t HANDLE);
+
+/**********************************************************************
+ * @brief Change the period of a task (the timeout of an event task).
+ * @details The task keeps its offset: it is next released on its new
+ *          schedule (the offset plus whole new periods from the start of
+ *          the scheduler), after the current tick. The other tasks are not
+ *          moved. If the tick time divides the new period, nothing else
+ *          changes. Otherwise, the tick time is reduced to the GCD of the
+ *          two, without stopping Timer 2: the switch happens at a tick
+ *          boundary, and the releases of all the tasks and timers keep
+ *          their times. After the start, the tick time is never
+ *          increased: a task removed or slowed down keeps it.
+ *          Before \ref cuteOS_Start(), only the period is stored.
+ * @param[in] \c HANDLE: Handle of the task.
+ * @param[in] \c PERIOD: The new period in time units (ms by default), greater than
+ *            the offset of the task. 0 is only allowed for an event task
+ *            (no timeout).
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_YES if the handle is not a task.
+ *          \ref ERROR_OUT_OF_RANGE if the period of the preemptive task
+ *          would not fit in 16-bit ticks, the period is not changed then.
+ *          \ref ERROR_BUSY if the task set would be overloaded
+ *          (\ref cuteOS_TaskCreateBudget()), the period is not changed then.
+ * @note    Not available with the static task set (\ref CUTEOS_CFG_STATIC).
+ *          The tick time switch relinks all the tasks and timers with the
+ *          interrupts disabled, keep the periods multiples of the tick
+ *          time to avoid it.
+ * @par Example
+ *      @code cuteOS_TaskSetPeriod(blink_handle, CUTEOS_MS(250));  // blink twice as fast @endcode
+ *********************************************************************/
+ERROR_t cuteOS_TaskSetPeriod(const cuteOS_TASK_HANDLE_t HANDLE, const u32_t PERIOD);
+
+
+/**********************************************************************
+ * @brief Start a software timer (\ref CUTEOS_CFG_TIMERS).
+ * @details The timer of \c callback is armed to expire after \c DURATION,
+ *          rounded up to whole ticks and counted from the current tick.
+ *          At expiry, the callback runs from \ref cuteOS_Start(), outside
+ *          the interrupt and before the ready tasks. A timer already
+ *          running for this callback is started again with the new
+ *          duration and mode. An auto-reload timer is linked again after
+ *          its callback ran, one duration after its previous expiry, so it
+ *          does not drift: the expiries missed meanwhile are skipped and
+ *          counted as overruns (\ref cuteOS_GetOverruns()).
+ * @param[in] \c callback: Pointer to the timer function, it identifies the timer.
+ * @param[in] \c DURATION: Duration in time units (ms by default) (32-bit).
+ * @param[in] \c MODE: \ref CUTEOS_TIMER_ONE_SHOT or \ref CUTEOS_TIMER_AUTO_RELOAD.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_OUT_OF_RANGE if all the timers are used.
+ * @note    The timers may be started before \ref cuteOS_Start(): the tick
+ *          time is not known yet, so they are scaled when it is set.
+ * @par Example
+ *      @code cuteOS_TimerStart(door_close, CUTEOS_MS(5000), CUTEOS_TIMER_ONE_SHOT); // door_close will run once, in 5 seconds @endcode
+ *********************************************************************/
+ERROR_t cuteOS_TimerStart(ERROR_t (* const callback)(void), const u32_t DURATION, const u8_t MODE);
+
+/**********************************************************************
+ * @brief Stop a software timer and release it.
+ * @details The pending run of the callback, if any, is dropped.
+ * @param[in] \c callback: Pointer to the timer function.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_YES if the timer is not found.
+ *********************************************************************/
+ERROR_t cuteOS_TimerStop(ERROR_t (* const callback)(void));
+
+/**********************************************************************
+ * @brief Start a software timer again with its last duration and mode.
+ * @details Works on a running timer (its expiry is pushed back, e.g. a
+ *          watchdog) and on an expired one-shot timer.
+ * @param[in] \c callback: Pointer to the timer function.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_YES if the timer was never started or was stopped.
+ *********************************************************************/
+ERROR_t cuteOS_TimerRestart(ERROR_t (* const callback)(void));
+
+/**********************************************************************
+ * @brief Get the time left until a software timer expires.
+ * @details The time is a whole number of ticks, in time units: divide it
+ *          by CUTEOS_MS(1) to get ms. A timer that is not running (expired
+ *          one-shot) has 0 left, as an auto-reload timer that expired and
+ *          waits for its callback to be linked again.
+ * @param[in] \c callback: Pointer to the timer function.
+ * @param[out] \c ptr_remaining: Pointer to the time left in time units.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_YES if the timer was never started or was stopped.
+ *********************************************************************/
+ERROR_t cuteOS_TimerRemaining(ERROR_t (* const callback)(void), u32_t * const ptr_remaining);
 
 /***************************************************************************
- * @brief   The OS enters 'idle mode' between clock ticks to save power. 
+ * @brief   Run the due tasks at each clock tick, and enter 'idle mode'
+ *          between clock ticks to save power. 
+ * @note    The tasks run outside the Timer 2 interrupt, highest priority first.
  * @note    The next clock tick will return the processor to the normal operating state.
  ***************************************************************************/
 void cuteOS_Start(void);
 
 /***************************************************************************
- * @brief   Get tick time in milliseconds.
- * @param[out] \c ptr_tick_time_ms: Pointer to the tick time in milliseconds.
+ * @brief   Allow or forbid the power-down mode (\ref CUTEOS_CFG_POWER_DOWN).
+ * @details When allowed (the default), \ref cuteOS_Start() enters power-down
+ *          mode instead of idle mode when nothing is due within
+ *          \ref CUTEOS_CFG_POWER_DOWN_HORIZON_MS: no task release (periodic
+ *          or event timeout), no timer expiry, no preemptive task. Only an
+ *          external interrupt enabled by \ref HAL_ExtIntEnable() wakes the
+ *          CPU up, its ISR typically sets an event (\ref cuteOS_EventSet()).
+ *
+ *          On wake-up, the time slept reported by \ref HAL_PowerDown() is
+ *          added to the tick count. The tasks and timers due meanwhile run
+ *          once, then the tasks go on at their next release on their usual
+ *          time grid (their phases are kept). On the classic 8051 no clock
+ *          runs in power-down, so the time slept is unknown: the tick count
+ *          stops, and all the releases are delayed by the time slept,
+ *          unless the application measures it (\ref HAL_CFG_SLEEP_CLOCK).
+ * @param[in] \c ALLOW: TRUE to allow, FALSE to forbid (e.g. while a UART
+ *            frame is being sent, its clock stops too).
+ * @note    A coroutine sleeping (\ref CUTE_SLEEP_MS()) across more than
+ *          2^31 time units of power-down may sleep up to 2^31 units longer.
+ * @par Example
+ *      @code
+ *      HAL_EXT_ISR(button_isr, 0) {
+ *          cuteOS_EventSet(EVENT_BUTTON);          // Releases the event task
+ *      }
+ *
+ *      HAL_ExtIntEnable(0, button_isr);            // INT0 wakes the CPU up
+ *      cuteOS_EventTaskCreate(button_task, EVENT_BUTTON, 0, 0, NULL);
+ *      cuteOS_Start();
+ *      @endcode
+ ***************************************************************************/
+void cuteOS_PowerDownEnable(const BOOL_t ALLOW);
+
+/***************************************************************************
+ * @brief   Get the number of task overruns.
+ * @details An overrun happens when a task is released while its previous
+ *          release has not run yet, because the tasks of the previous tick
+ *          took longer than the tick time. The expiries of an auto-reload
+ *          timer missed while its callback was pending count too.
+ * @param[out] \c ptr_overruns: Pointer to the number of overruns.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ ***************************************************************************/
+ERROR_t cuteOS_GetOverruns(u16_t * const ptr_overruns);
+
+/***************************************************************************
+ * @brief   Get the execution time of the Timer 2 ISR (\ref CUTEOS_CFG_ISR_STATS).
+ * @param[out] \c ptr_stats: Pointer to the statistics.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ ***************************************************************************/
+ERROR_t cuteOS_GetIsrStats(cuteOS_ISR_STATS_t * const ptr_stats);
+
+/***************************************************************************
+ * @brief   Get the execution time statistics of a task (\ref CUTEOS_CFG_TASK_STATS).
+ * @details Each run is measured from the Timer 2 count sampled before and
+ *          after the task function. The interrupts that preempt the task
+ *          (including the preemptive task of the hybrid mode) are counted
+ *          in its execution time.
+ * @param[in] \c HANDLE: Handle of the task, see \ref cuteOS_TaskCreate().
+ * @param[out] \c ptr_stats: Pointer to the statistics.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_YES if the handle is not a task.
+ * @par Example
+ *      @code
+ *      cuteOS_TASK_STATS_t stats;
+ *      cuteOS_GetTaskStats(task1_handle, &stats);  // stats.max_cycles is the WCET of task1
+ *      @endcode
+ ***************************************************************************/
+ERROR_t cuteOS_GetTaskStats(const cuteOS_TASK_HANDLE_t HANDLE, cuteOS_TASK_STATS_t * const ptr_stats);
+
+/***************************************************************************
+ * @brief   Get the CPU load (\ref CUTEOS_CFG_LOAD_STATS).
+ * @details The idle time is measured from the Timer 2 count sampled
+ *          before and after the idle mode of \ref cuteOS_Start(), the rest
+ *          of the window is busy: the tasks, the timer callbacks, the
+ *          scheduler and the interrupts. The interrupt that ends the idle
+ *          mode is counted as idle. A window is closed at the first pass
+ *          of the scheduler loop after its end, so it may be longer than
+ *          \ref CUTEOS_CFG_LOAD_WINDOW_MS under full load.
+ * @param[out] \c ptr_stats: Pointer to the statistics.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ * @par Example
+ *      @code
+ *      cuteOS_LOAD_STATS_t load;
+ *      cuteOS_GetLoadStats(&load);     // load.load_peak < 700: room for another task
+ *      @endcode
+ ***************************************************************************/
+ERROR_t cuteOS_GetLoadStats(cuteOS_LOAD_STATS_t * const ptr_stats);
+
+/***************************************************************************
+ * @brief   Start or stop recording the trace (\ref CUTEOS_CFG_TRACE).
+ * @details The trace records from the start. Stop it when a fault is
+ *          detected, so the events that led to it are not overwritten.
+ * @param[in] \c ENABLE: TRUE to record, FALSE to stop.
+ ***************************************************************************/
+void cuteOS_TraceEnable(const BOOL_t ENABLE);
+
+/***************************************************************************
+ * @brief   Send the recorded events, oldest first, then empty the trace
+ *          (\ref CUTEOS_CFG_TRACE).
+ * @details The recording stops during the dump. The dump is a byte
+ *          stream, the 16-bit fields are little endian:
+ *          - "cTR" and the format version (1).
+ *          - Timer 2 increments per ms (16 bits).
+ *          - Number N of events (16 bits).
+ *          - Number of events lost, overwritten before the dump (16 bits,
+ *            saturates at 65535).
+ *          - N events: type, argument, time (16 bits, see
+ *            \ref CUTEOS_TRACE_TICK).
+ *          The time wraps around every 65536 increments: the host
+ *          unwraps it, which works because every Timer 2 period records a
+ *          \ref CUTEOS_TRACE_TICK (keep the interrupts enabled).
+ * @param[in] \c put_byte: Function that sends one byte (e.g. to the UART).
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ * @par Example
+ *      @code
+ *      void uart_put(const u8_t BYTE) { SBUF = BYTE; while(!TI); TI = 0; }
+ *      cuteOS_TraceDump(uart_put);     // trace/trace2json.c converts it (make -f trace.mk)
+ *      @endcode
+ ***************************************************************************/
+ERROR_t cuteOS_TraceDump(void (* const put_byte)(const u8_t BYTE));
+
+/***************************************************************************
+ * @brief   Get the number of overloaded ticks (\ref CUTEOS_CFG_TASK_STATS).
+ * @details A tick is overloaded when the tasks run back to back for
+ *          longer than the tick time: each full tick time of continuous
+ *          work counts as one overloaded tick.
+ * @param[out] \c ptr_overloads: Pointer to the number of overloaded ticks.
  * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
-ERROR_t cuteOS_GetTickTime(u8_t * const ptr_tick_time_ms);
+ ***************************************************************************/
+ERROR_t cuteOS_GetOverloads(u16_t * const ptr_overloads);
+
+/**********************************************************************
+ * @brief Create the preemptive task of the hybrid mode (\ref CUTEOS_CFG_HYBRID).
+ * @details The task runs directly from the Timer 2 interrupt every
+ *          \c PERIOD, before the cooperative tasks are released. So, its
+ *          jitter does not depend on the cooperative tasks. Only one
+ *          preemptive task is allowed.
+ * @param[in] \c task_ptr: Pointer to the task function. It must be short
+ *            (much shorter than the tick time) and, on the 8051, compiled
+ *            with \c #pragma \c NOAREGS because it runs on the register
+ *            bank \ref CUTEOS_CFG_ISR_BANK.
+ * @param[in] \c PERIOD: the period of task execution in time units (ms by default).
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_BUSY if the preemptive task already exists.
+ * @par Example
+ *      @code cuteOS_PreemptiveTaskCreate(control_loop, CUTEOS_MS(5)); // control_loop will run every 5 ms @endcode
+ *********************************************************************/
+ERROR_t cuteOS_PreemptiveTaskCreate(ERROR_t (* const task_ptr)(void), const u32_t PERIOD);
+
+/**********************************************************************
+ * @brief Remove the preemptive task of the hybrid mode.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *********************************************************************/
+ERROR_t cuteOS_PreemptiveTaskRemove(void);
+
+/**********************************************************************
+ * @brief Enter a critical section protecting data shared with the
+ *        preemptive task.
+ * @details Only the Timer 2 interrupt is disabled, the other interrupts
+ *          keep running. Critical sections can be nested, the Timer 2
+ *          interrupt is enabled again by the outermost \ref cuteOS_CriticalExit().
+ *          Keep them short: the preemptive task is delayed until the exit.
+ * @note    To be called from the cooperative tasks only.
+ * @par Example
+ *      @code
+ *      cuteOS_CriticalEnter();
+ *      setpoint = new_setpoint;      // 16-bit value read by the preemptive task
+ *      cuteOS_CriticalExit();
+ *      @endcode
+ *********************************************************************/
+void cuteOS_CriticalEnter(void);
+
+/**********************************************************************
+ * @brief Exit a critical section entered by \ref cuteOS_CriticalEnter().
+ *********************************************************************/
+void cuteOS_CriticalExit(void);
+
+/***************************************************************************
+ * @brief   Get the number of ticks since the scheduler started.
+ * @details The 32-bit tick count is read consistently without disabling
+ *          the interrupts. It wraps around after 2^32 ticks. When the tick
+ *          time is reduced, it is scaled to the new ticks.
+ * @param[out] \c ptr_ticks: Pointer to the tick count.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ ***************************************************************************/
+ERROR_t cuteOS_GetTicks32(u32_t * const ptr_ticks);
+
+/***************************************************************************
+ * @brief   Get the time since the scheduler started in microseconds.
+ * @details The tick count is extended with the live Timer 2 count, so the
+ *          resolution is one instruction cycle (1 us with a 12 MHz crystal)
+ *          instead of the tick time. The values are read consistently
+ *          without disabling the interrupts. The time wraps around after
+ *          2^32 us (about 71 minutes): compute intervals as unsigned
+ *          differences.
+ * @param[out] \c ptr_time_us: Pointer to the time in us.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ * @par Example
+ *      @code
+ *      u32_t start, end;
+ *      cuteOS_GetTimeUs(&start);
+ *      do_something();
+ *      cuteOS_GetTimeUs(&end);
+ *      duration_us = end - start;
+ *      @endcode
+ ***************************************************************************/
+ERROR_t cuteOS_GetTimeUs(u32_t * const ptr_time_us);
+
+/***************************************************************************
+ * @brief   Wake-up time of a sleep of a coroutine, see \ref CUTE_SLEEP_MS().
+ * @details The wake-up time is in time units, not in ticks: a change of the
+ *          tick time during the sleep (a task created, or a period changed
+ *          by \ref cuteOS_TaskSetPeriod()) does not change its duration.
+ * @param[in] \c DURATION: Duration of the sleep in time units, less
+ *            than 2^31. It ends at the first tick after it.
+ * @return  \c u32_t: The time (in time units) at which the sleep ends.
+ ***************************************************************************/
+u32_t cuteOS_CoroWake(const u32_t DURATION);
+
+/***************************************************************************
+ * @brief   Check whether a sleep of a coroutine is over.
+ * @param[in] \c WAKE: The wake-up time from \ref cuteOS_CoroWake().
+ * @return  \c BOOL_t: TRUE if the time reached \c WAKE.
+ ***************************************************************************/
+BOOL_t cuteOS_CoroAwake(const u32_t WAKE);
+
+/***************************************************************************
+ * @brief   Get tick time in time units (ms by default, see
+ *          \ref CUTEOS_CFG_TIME_UNIT_US).
+ * @param[out] \c ptr_tick_time: Pointer to the tick time in time units.
+ * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ ***************************************************************************/
+ERROR_t cuteOS_GetTickTime(u16_t * const ptr_tick_time);
+
+#if defined(HAL_SDCC)
+#include "cuteOS_cfg.h"
+
+/*!< SDCC generates the interrupt vectors in the module of main(), from this prototype */
+#if CUTEOS_ISR_BANKED
+HAL_TIMER_ISR_USING(cuteOS_ISR, CUTEOS_CFG_ISR_BANK);
+#else
+HAL_TIMER_ISR(cuteOS_ISR);
+#endif
+#endif
 
-#endif /* SIMPLE_EOS_H */
\ No newline at end of file
+#endif /* CUTE_OS_H */
@@ -0,0 +1,240 @@
+/***************************************************************************
+ * @file    cuteOS_cfg.h
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Configurations of the Cute OS. See \ref cuteOS.c for more details.
+ * @version 1.0.0
+ * @date    2022-04-22
+ * @copyright Copyright (c) 2022
+ ***************************************************************************/
+#ifndef CUTE_OS_CFG_H
+#define CUTE_OS_CFG_H
+
+/*-------------------------------------------------------------------------*/
+/*                YOU CAN CHANGE THE FOLLOWING PARAMETERS				   */
+/*      (or override them from the compiler command line, e.g. -D...)      */
+/*-------------------------------------------------------------------------*/
+/***************************************************************************
+ * @brief   Maximum number of tasks (up to 254).
+ * @details The tasks and the timing wheel are stored in XDATA, so the
+ *          target must have on-chip XRAM or external RAM. Each task takes
+ *          sizeof(cuteOS_TASK_t) bytes of XDATA (see cuteOS.c), with Keil
+ *          C51 (3-byte function pointers, SDCC takes one byte less):
+ *          - 32 bytes: the function, five 32-bit times (period, offset,
+ *            ticks, phase, next release) and nine 8-bit links and flags.
+ *          - 4 more with \ref CUTEOS_CFG_EVENTS.
+ *          - 14 more with \ref CUTEOS_CFG_TASK_STATS.
+ *          - 2 more with \ref CUTEOS_CFG_ADMISSION.
+ *
+ *          That is 50 bytes with the default options, 1600 bytes for 32
+ *          tasks. The timing wheel takes 128 bytes.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_MAX_TASKS
+#define CUTEOS_CFG_MAX_TASKS        32
+#endif
+
+/***************************************************************************
+ * @brief   Time unit of the kernel in us, a divisor of 1000 (default: 1 ms).
+ * @details The periods, offsets, timeouts and durations given to the
+ *          kernel, and the tick time, are in this unit (see
+ *          \ref CUTEOS_MS() and \ref CUTEOS_US()). 1000 keeps the ms, 100
+ *          or 1 allow periods and ticks below 1 ms for fast control loops,
+ *          down to one Timer 2 increment. The tick time is still the GCD of
+ *          the periods, at most one Timer 2 period (65 ms at 12 MHz), and
+ *          the options named ..._MS below stay in ms.
+ *          The ISR must end well before the next tick: measure it with
+ *          \ref CUTEOS_CFG_ISR_STATS or the benchmark suite (bench.mk).
+ *          Below 1 ms, the ISR runs on the register bank
+ *          \ref CUTEOS_CFG_ISR_BANK.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_TIME_UNIT_US
+#define CUTEOS_CFG_TIME_UNIT_US     1000
+#endif
+
+/***************************************************************************
+ * @brief   Tickless idle mode (1: enabled, 0: disabled).
+ * @details When enabled, Timer 2 is reprogrammed to overflow at the next
+ *          task release instead of every tick, so the CPU stays in idle
+ *          mode for several ticks. Intervals longer than one Timer 2
+ *          period are covered by chaining several overflows.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_TICKLESS
+#define CUTEOS_CFG_TICKLESS         0
+#endif
+
+/***************************************************************************
+ * @brief   Power-down mode (1: enabled, 0: disabled).
+ * @details When enabled, \ref cuteOS_Start() enters power-down mode
+ *          instead of idle mode when no task release, no timer expiry and
+ *          no preemptive task is due within
+ *          \ref CUTEOS_CFG_POWER_DOWN_HORIZON_MS. Every clock stops, Timer 2
+ *          included, until an external interrupt (INT0 or INT1, see
+ *          \ref HAL_ExtIntEnable()) wakes the CPU up: it suits the systems
+ *          driven by their inputs, the work due after the horizon waits
+ *          for the next wake-up. See \ref cuteOS_PowerDownEnable().
+ * @warning On a classic 8051 the time and the periodic phase are lost at
+ *          each power-down: no clock runs, so the time slept is unknown and
+ *          the tick count stops. Every release, timer and coroutine sleep
+ *          is delayed by the time slept, and the tasks are no longer in
+ *          phase with the wall clock. To keep them, measure the sleep with
+ *          a clock running in power-down (a wake-up timer, a watchdog, an
+ *          RTC) through \ref HAL_CFG_SLEEP_CLOCK. The POSIX HAL measures it.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_POWER_DOWN
+#define CUTEOS_CFG_POWER_DOWN       0
+#endif
+
+/***************************************************************************
+ * @brief   Shortest time to the next due work that allows power-down, in ms.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_POWER_DOWN_HORIZON_MS
+#define CUTEOS_CFG_POWER_DOWN_HORIZON_MS    1000
+#endif
+
+/***************************************************************************
+ * @brief   Hybrid preemptive mode (1: enabled, 0: disabled).
+ * @details When enabled, one task created by \ref cuteOS_PreemptiveTaskCreate()
+ *          runs directly from the Timer 2 interrupt, on its own register
+ *          bank, and preempts the cooperative tasks. Data shared between
+ *          this task and the cooperative tasks must be accessed between
+ *          \ref cuteOS_CriticalEnter() and \ref cuteOS_CriticalExit().
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_HYBRID
+#define CUTEOS_CFG_HYBRID           0
+#endif
+
+/***************************************************************************
+ * @brief   Register bank (1 to 3) of the Timer 2 ISR in hybrid mode or
+ *          with a time unit below 1 ms (\ref CUTEOS_CFG_TIME_UNIT_US).
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_ISR_BANK
+#define CUTEOS_CFG_ISR_BANK         1
+#endif
+
+/***************************************************************************
+ * @brief   Per-task execution time statistics (1: enabled, 0: disabled).
+ * @details When enabled, Timer 2 is sampled before and after each task and
+ *          the minimum, maximum and average execution times are kept. See
+ *          \ref cuteOS_GetTaskStats(). Costs 14 bytes of XDATA per
+ *          task and two timer samples per task run.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_TASK_STATS
+#define CUTEOS_CFG_TASK_STATS       1
+#endif
+
+/***************************************************************************
+ * @brief   Timer 2 ISR execution time measurement (1: enabled, 0: disabled).
+ * @details When enabled, the ISR samples Timer 2 at its start and its end.
+ *          See \ref cuteOS_GetIsrStats(). Used by the benchmark suite,
+ *          it adds two timer samples to every tick.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_ISR_STATS
+#define CUTEOS_CFG_ISR_STATS        0
+#endif
+
+/***************************************************************************
+ * @brief   CPU load measurement (1: enabled, 0: disabled).
+ * @details When enabled, Timer 2 is sampled around the idle mode of
+ *          \ref cuteOS_Start(), and the busy share of each window of
+ *          \ref CUTEOS_CFG_LOAD_WINDOW_MS is computed. See
+ *          \ref cuteOS_GetLoadStats(). Costs two timer samples per idle
+ *          entry.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_LOAD_STATS
+#define CUTEOS_CFG_LOAD_STATS       1
+#endif
+
+/***************************************************************************
+ * @brief   Length of a CPU load window in ms (1 to 4000).
+ * @details The peak load is the load of the busiest window: a shorter
+ *          window shows shorter bursts.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_LOAD_WINDOW_MS
+#define CUTEOS_CFG_LOAD_WINDOW_MS   1000
+#endif
+
+/***************************************************************************
+ * @brief   Event trace (1: enabled, 0: disabled).
+ * @details When enabled, the ticks, the task and timer runs, the task
+ *          creations and removals and the overruns are recorded in a ring
+ *          of \ref CUTEOS_CFG_TRACE_SIZE events in XDATA (4 bytes each),
+ *          the oldest events are overwritten. \ref cuteOS_TraceDump()
+ *          sends it to the host, where trace/trace2json.c (built by
+ *          trace.mk) converts it for the Chrome or Perfetto trace viewers.
+ *          When disabled, the trace costs no code, no data and no cycles.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_TRACE
+#define CUTEOS_CFG_TRACE            0
+#endif
+
+/***************************************************************************
+ * @brief   Number of events of the trace, a power of two from 2 to 256.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_TRACE_SIZE
+#define CUTEOS_CFG_TRACE_SIZE       128
+#endif
+
+/***************************************************************************
+ * @brief   Static task set (1: enabled, 0: disabled).
+ * @details When enabled, the tasks are listed in \ref cuteOS_tasks_cfg.h
+ *          instead of being created at runtime, with their tick time
+ *          (\ref CUTEOS_CFG_STATIC_TICK). The compiler checks the tick time
+ *          and computes the ticks of each task and the Timer 2 reload value,
+ *          the task table is stored in CODE memory and the tasks array is
+ *          sized to the task set. cuteOS_TaskCreate() and the 32-bit
+ *          divisions of the GCD are not linked. cuteOS_TaskRemove() is
+ *          still available.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_STATIC
+#define CUTEOS_CFG_STATIC           0
+#endif
+
+/***************************************************************************
+ * @brief   Automatic release offsets (1: enabled, 0: disabled).
+ * @details When enabled, the tasks created by \ref cuteOS_TaskCreate() (and
+ *          the static task set) get their release offsets chosen so that
+ *          as few tasks as possible are released in the same tick. The
+ *          periods do not change, the work is spread over the ticks in
+ *          between. See \ref cuteOS_TaskCreateOffset() for fixed offsets.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_BALANCE
+#define CUTEOS_CFG_BALANCE          0
+#endif
+
+/***************************************************************************
+ * @brief   Admission control (1: enabled, 0: disabled).
+ * @details When enabled, a task may declare its worst-case execution time
+ *          (\ref cuteOS_TaskCreateBudget()), and a task is refused at its
+ *          creation (or a period change) if the task set would not fit in
+ *          the CPU time: see \ref cuteOS_TaskCreateBudget() for the checks.
+ *          Costs 2 bytes per task. Not available with the static task set
+ *          (\ref CUTEOS_CFG_STATIC): check it with the analyzer instead
+ *          (analyzer.mk).
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_ADMISSION
+#define CUTEOS_CFG_ADMISSION        0
+#endif
+
+/***************************************************************************
+ * @brief   Number of software timers (0 to 254, 0: disabled).
+ * @details The timers are started by \ref cuteOS_TimerStart() and call
+ *          their callback once (one-shot) or periodically (auto-reload).
+ *          The armed timers are kept sorted by expiry, so the Timer 2 ISR
+ *          only compares the tick count with the first one. Each timer
+ *          takes about 16 bytes of XDATA.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_TIMERS
+#define CUTEOS_CFG_TIMERS           4
+#endif
+
+/***************************************************************************
+ * @brief   Event flags (1: enabled, 0: disabled).
+ * @details When enabled, the tasks created by \ref cuteOS_EventTaskCreate()
+ *          run when one of their events is set by \ref cuteOS_EventSet()
+ *          (from an ISR or a task), or after a timeout, instead of
+ *          periodically. Costs 4 bytes of XDATA per task.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_EVENTS
+#define CUTEOS_CFG_EVENTS           1
+#endif
+
+#endif /* CUTE_OS_CFG_H */
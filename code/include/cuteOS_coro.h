@@ -0,0 +1,124 @@
+/***************************************************************************
+ * @file    cuteOS_coro.h
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Stackless coroutines (protothreads) on top of the cuteOS tasks.
+ * @details A coroutine is a task function written as a sequence of steps:
+ *          it can wait (\ref CUTE_YIELD(), \ref CUTE_SLEEP_MS(),
+ *          \ref CUTE_WAIT_UNTIL()) and resume at the same place at one of
+ *          its next runs, without a stack of its own. The task returns at
+ *          each wait, so the other tasks run meanwhile, and a long job can
+ *          be split into short slices without writing a state machine.
+ *
+ *          The place to resume is the source line of the wait, kept in a
+ *          \ref cuteOS_CORO_t with the wake-up time of the sleeps: 6 bytes
+ *          per coroutine. The body is a switch on that line, so:
+ *          - The local variables are lost at each wait: use static ones.
+ *          - No switch statement in the body around a wait, and only one
+ *            wait per source line.
+ *
+ *          The coroutine resumes when its task runs: it is created by
+ *          \ref cuteOS_TaskCreate() (its period is the resolution of the
+ *          waits) or by \ref cuteOS_EventTaskCreate(). After
+ *          \ref CUTE_END(), the next run starts from the top again.
+ * @par Example
+ * @code
+ *          ERROR_t blink(void) {
+ *              static cuteOS_CORO_t coro;      // Zero: starts from the top
+ *              static u8_t i;                  // Kept between the runs
+ *
+ *              CUTE_BEGIN(coro);
+ *              for(i = 0; i < 3; ++i) {
+ *                  HAL_PIN_WRITE(led1Pin, HIGH);
+ *                  CUTE_SLEEP_MS(200);
+ *                  HAL_PIN_WRITE(led1Pin, LOW);
+ *                  CUTE_SLEEP_MS(200);
+ *              }
+ *              CUTE_WAIT_UNTIL(HAL_PIN_READ(buttonPin) == LOW);
+ *              CUTE_END();
+ *          }
+ *
+ *          cuteOS_TaskCreate(blink, CUTEOS_MS(50), CUTEOS_PRIO_AUTO, NULL);   // Resumes every 50 ms
+ * @endcode
+ * @version 1.0.0
+ * @date    2022-05-12
+ * @copyright Copyright (c) 2022
+ ***************************************************************************/
+#ifndef CUTE_OS_CORO_H
+#define CUTE_OS_CORO_H
+
+#include "STD_TYPES.h"
+#include "cuteOS.h"
+
+/***************************************************************************
+ * @brief   State of a coroutine, must be static and zero at the start.
+ ***************************************************************************/
+typedef struct {
+    u16_t line;     /*!< Source line of the wait to resume at, 0: the top */
+    u32_t wake;     /*!< Time (in time units) at which the sleep ends */
+}cuteOS_CORO_t;
+
+/***************************************************************************
+ * @brief   Start the body of a coroutine, resuming at its last wait.
+ * @param[in] CORO: The state of the coroutine (\ref cuteOS_CORO_t).
+ ***************************************************************************/
+#define CUTE_BEGIN(CORO)                                                    \
+    {                                                                       \
+        cuteOS_CORO_t * const cute_coro = &(CORO);                          \
+        switch(cute_coro->line) {                                           \
+        case 0:
+
+/***************************************************************************
+ * @brief   End the body of a coroutine: the next run starts from the top.
+ ***************************************************************************/
+#define CUTE_END()                                                          \
+        }                                                                   \
+        cute_coro->line = 0;                                                \
+        return ERROR_NO;                                                    \
+    }
+
+/***************************************************************************
+ * @brief   Return now, and resume here at the next run of the task.
+ ***************************************************************************/
+#define CUTE_YIELD()                                                        \
+    do {                                                                    \
+        cute_coro->line = __LINE__;                                         \
+        return ERROR_NO;                                                    \
+        case __LINE__:;                                                     \
+    } while(0)
+
+/***************************************************************************
+ * @brief   Return at each run of the task until COND is true, then go on.
+ * @details COND is checked at once: if it is already true, the coroutine
+ *          does not return.
+ ***************************************************************************/
+#define CUTE_WAIT_UNTIL(COND)                                               \
+    do {                                                                    \
+        cute_coro->line = __LINE__;                                         \
+        case __LINE__:                                                      \
+        if(!(COND)) {                                                       \
+            return ERROR_NO;                                                \
+        }                                                                   \
+    } while(0)
+
+/***************************************************************************
+ * @brief   Return at each run of the task until MS milliseconds elapsed.
+ * @details The sleep ends at the first run of the task after it, so the
+ *          resolution is the period of the task. See \ref cuteOS_CoroWake()
+ *          for the longest sleep.
+ ***************************************************************************/
+#define CUTE_SLEEP_MS(MS)                                                   \
+    do {                                                                    \
+        cute_coro->wake = cuteOS_CoroWake(CUTEOS_MS(MS));                   \
+        CUTE_WAIT_UNTIL(TRUE == cuteOS_CoroAwake(cute_coro->wake));         \
+    } while(0)
+
+/***************************************************************************
+ * @brief   Return now, and start from the top at the next run of the task.
+ ***************************************************************************/
+#define CUTE_RESTART()                                                      \
+    do {                                                                    \
+        cute_coro->line = 0;                                                \
+        return ERROR_NO;                                                    \
+    } while(0)
+
+#endif /* CUTE_OS_CORO_H */
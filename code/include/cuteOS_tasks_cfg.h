@@ -0,0 +1,73 @@
+/***************************************************************************
+ * @file    cuteOS_tasks_cfg.h
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Static task set of the Cute OS (\ref CUTEOS_CFG_STATIC mode).
+ * @details The tasks are listed here instead of being created by
+ *          \ref cuteOS_TaskCreate(), with their tick time. The number of
+ *          ticks of each task and the Timer 2 reload value are computed by
+ *          the compiler, and the task table is placed in CODE memory.
+ * @version 1.0.0
+ * @date    2022-04-30
+ * @copyright Copyright (c) 2022
+ ***************************************************************************/
+#ifndef CUTE_OS_TASKS_CFG_H
+#define CUTE_OS_TASKS_CFG_H
+
+/*--------------------------------------------------------------------*/
+/*                          TASK FUNCTIONS                            */
+/*--------------------------------------------------------------------*/
+ERROR_t led1_toggle(void);
+ERROR_t led2_toggle(void);
+ERROR_t led3_toggle(void);
+ERROR_t motor_toggle(void);
+
+
+/*-------------------------------------------------------------------------*/
+/*                YOU CAN CHANGE THE FOLLOWING PARAMETERS				   */
+/*-------------------------------------------------------------------------*/
+/***************************************************************************
+ * @brief   The static task set: one TASK(function, period, priority) per
+ *          task.
+ * @details - The periods are integer constants in time units: give them
+ *            with \ref CUTEOS_MS() to keep them in ms at any
+ *            \ref CUTEOS_CFG_TIME_UNIT_US.
+ *          - The priorities are \ref CUTEOS_PRIO_HIGHEST to
+ *            \ref CUTEOS_PRIO_LOWEST, or \ref CUTEOS_PRIO_AUTO.
+ *          - The tasks run in the order of the list when they are due at
+ *            the same tick with the same priority.
+ ***************************************************************************/
+#define CUTEOS_CFG_STATIC_TASKS(TASK)                           \
+    TASK(led1_toggle,   CUTEOS_MS(1000),    CUTEOS_PRIO_AUTO)   \
+    TASK(led2_toggle,   CUTEOS_MS(2000),    CUTEOS_PRIO_AUTO)   \
+    TASK(led3_toggle,   CUTEOS_MS(4000),    CUTEOS_PRIO_AUTO)   \
+    TASK(motor_toggle,  CUTEOS_MS(5000),    CUTEOS_PRIO_AUTO)
+
+/***************************************************************************
+ * @brief   Tick time of the static task set, in time units (see
+ *          \ref CUTEOS_MS()): 50 ms by default.
+ * @details It must divide every period and fit one Timer 2 period
+ *          (\ref CUTEOS_MAX_TICK_TIME, 65 ms at 12 MHz): both are checked by
+ *          the compiler, and a task set
+ *          that breaks them does not build. The longest tick that divides
+ *          all the periods wakes the CPU up the least: the analyzer
+ *          (analyzer.mk) prints it.
+ ***************************************************************************/
+#ifndef CUTEOS_CFG_STATIC_TICK
+#define CUTEOS_CFG_STATIC_TICK      CUTEOS_MS(50)
+#endif
+
+/***************************************************************************
+ * @brief   The worst-case execution time budgets of the tasks: one
+ *          BUDGET(function, WCET in us) per task, for the schedulability
+ *          analyzer (analyzer.mk), which checks this task set at build
+ *          time. A task not listed has no budget.
+ * @details The same budgets can be given at run time to
+ *          \ref cuteOS_TaskCreateBudget() (\ref CUTEOS_CFG_ADMISSION).
+ ***************************************************************************/
+#define CUTEOS_CFG_TASK_BUDGETS(BUDGET)                         \
+    BUDGET(led1_toggle,     40)                                 \
+    BUDGET(led2_toggle,     40)                                 \
+    BUDGET(led3_toggle,     40)                                 \
+    BUDGET(motor_toggle,    60)
+
+#endif /* CUTE_OS_TASKS_CFG_H */
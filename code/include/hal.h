@@ -0,0 +1,370 @@
+/***************************************************************************
+ * @file    hal.h
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Hardware Abstraction Layer (HAL) interfaces of cuteOS.
+ * @details The HAL hides the target specific parts used by cuteOS and the
+ *          application:
+ *              - Timer 2 (the scheduler tick) and its interrupt.
+ *              - Global interrupts enable/disable.
+ *              - The external interrupts INT0 and INT1.
+ *              - CPU idle and power-down modes.
+ *              - General purpose I/O pins and ports.
+ *          Two backends are available:
+ *              - \ref HAL_8051 : The build for the 8051 target. It is selected
+ *                automatically when \c __C51__ (Keil C51) or \c __SDCC_mcs51
+ *                (SDCC, \ref HAL_SDCC) is defined.
+ *              - \ref HAL_POSIX : A native Linux build. A POSIX timer signal
+ *                stands in for Timer 2 overflow and calls the same scheduler
+ *                ISR, so the kernel can be built and profiled on a host.
+ *                See \ref hal_posix.c for details.
+ *
+ *          The hot paths (interrupt acknowledge, interrupts enable/disable,
+ *          idle, GPIO) are macros, so the 8051 build generates exactly the
+ *          same instructions as writing the SFRs directly.
+ * @version 1.0.0
+ * @date    2022-04-20
+ * @copyright Copyright (c) 2022
+ ***************************************************************************/
+#ifndef HAL_H
+#define HAL_H
+
+#if defined(__C51__)
+    #define HAL_8051
+#elif defined(__SDCC_mcs51)
+    #define HAL_8051
+    #define HAL_SDCC        /*!< SDCC spelling of the 8051 keywords */
+#else
+    #define HAL_POSIX
+#endif
+
+/*--------------------------------------------------------------------*/
+/*                          COMMON DEFINITIONS                        */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @brief   Number of Timer 2 increments in one millisecond.
+ * @details Timer 2 is incremented once every instruction cycle, so:
+ *          increments per ms = (OSC_FREQ / 1000) / OSC_PER_INST.
+ *********************************************************************/
+#define HAL_TIMER_INC_PER_MS        ( (OSC_FREQ / 1000UL) / (u32_t)OSC_PER_INST )
+
+/**********************************************************************
+ * @brief   Timer 2 reload value that makes it overflow after \c INC increments.
+ *********************************************************************/
+#define HAL_TIMER_RELOAD(INC)       ( (u16_t)(65536UL - (u32_t)(INC)) )
+
+/**********************************************************************
+ * @brief   A clock of the application runs in power-down (1: yes, 0: no).
+ *          Used by the 8051 backend only.
+ * @details The classic 8051 stops every clock in power-down, so
+ *          \ref HAL_PowerDown() cannot tell how long it slept. Some
+ *          derivatives keep a wake-up timer or a watchdog counting on an
+ *          internal RC oscillator, and some boards have an RTC: set this
+ *          option to 1 and implement \ref HAL_SleepClockStart() and
+ *          \ref HAL_SleepClockRead() with it, so the time slept is known.
+ *********************************************************************/
+#ifndef HAL_CFG_SLEEP_CLOCK
+#define HAL_CFG_SLEEP_CLOCK         0
+#endif
+
+
+#if defined(HAL_8051)
+/*--------------------------------------------------------------------*/
+/*                          8051 BACKEND                              */
+/*--------------------------------------------------------------------*/
+#if defined(HAL_SDCC)
+#include <8052.h>
+
+#define HAL_CODE        __code
+#define HAL_DATA        __data
+#define HAL_IDATA       __idata
+#define HAL_XDATA       __xdata
+#else
+#include <reg52.h>
+
+/*!< Memory spaces: the 8051 has separate CODE, DATA, IDATA and XDATA spaces */
+#define HAL_CODE        code
+#define HAL_DATA        data
+#define HAL_IDATA       idata
+#define HAL_XDATA       xdata
+#endif
+
+/**********************************************************************
+ * @brief   Define the Timer 2 overflow interrupt service routine.
+ * @par Example
+ *      @code HAL_TIMER_ISR(cuteOS_ISR) { HAL_TIMER_ISR_ACK(); ... } @endcode
+ * @note    SDCC generates the interrupt vectors in the module of main(),
+ *          so with SDCC the ISR is not static and its prototype must be
+ *          visible in that module.
+ *********************************************************************/
+#if defined(HAL_SDCC)
+#define HAL_TIMER_ISR(NAME)     void NAME(void) __interrupt(INTERRUPT_Timer_2_Overflow)
+#else
+#define HAL_TIMER_ISR(NAME)     static void NAME(void) interrupt INTERRUPT_Timer_2_Overflow
+#endif
+
+/**********************************************************************
+ * @brief   Define the Timer 2 overflow ISR running on register bank \c BANK.
+ * @details The ISR switches to its own register bank instead of pushing
+ *          R0 to R7, so it can preempt the main program cheaply.
+ * @note    The functions called from the ISR must not use absolute register
+ *          addresses of bank 0: compile them with \c #pragma \c NOAREGS.
+ *********************************************************************/
+#if defined(HAL_SDCC)
+#define HAL_TIMER_ISR_USING(NAME, BANK)     void NAME(void) __interrupt(INTERRUPT_Timer_2_Overflow) __using(BANK)
+#else
+#define HAL_TIMER_ISR_USING(NAME, BANK)     static void NAME(void) interrupt INTERRUPT_Timer_2_Overflow using BANK
+#endif
+
+/**********************************************************************
+ * @brief   Define the ISR of the external interrupt \c INT (0: INT0, 1: INT1).
+ * @details See \ref HAL_ExtIntEnable(). Like \ref HAL_TIMER_ISR, with SDCC
+ *          the ISR is not static and must be declared in the module of main().
+ * @par Example
+ *      @code HAL_EXT_ISR(button_isr, 0) { cuteOS_EventSet(EVENT_BUTTON); } @endcode
+ *********************************************************************/
+#if defined(HAL_SDCC)
+#define HAL_EXT_ISR(NAME, INT)  void NAME(void) __interrupt(INTERRUPT_External_##INT)
+#else
+#define HAL_EXT_ISR(NAME, INT)  static void NAME(void) interrupt INTERRUPT_External_##INT
+#endif
+
+/*!< Timer 2 overflow flag must be cleared manually by the ISR */
+#define HAL_TIMER_ISR_ACK()     ( TF2 = 0 )
+
+/**********************************************************************
+ * @brief   Load the reload value of Timer 2 without stopping it.
+ * @details The new value is used from the next overflow on, so the
+ *          running period is not disturbed. Call it early in a period
+ *          (e.g. from the Timer 2 ISR), so the overflow cannot happen
+ *          between the writes of the two bytes.
+ *********************************************************************/
+#define HAL_TimerSetReload(RELOAD)  ( RCAP2H = (u8_t)((RELOAD) >> 8), RCAP2L = (u8_t)(RELOAD) )
+
+/*!< Timer 2 overflowed and its interrupt is not serviced yet */
+#define HAL_TimerOverflowPending()  ( TF2 )
+
+#define HAL_INT_ENABLE()        ( EA = 1 )      /*!< Globally enable interrupts  */
+#define HAL_INT_DISABLE()       ( EA = 0 )      /*!< Globally disable interrupts */
+
+/**********************************************************************
+ * @brief   Save the global interrupt enable in \c STATE (a u8_t), then
+ *          disable the interrupts.
+ * @details \ref HAL_INT_RESTORE() enables them again only if they were
+ *          enabled, so the pair may be used in an ISR, or in a task that
+ *          already disabled them, without ending its critical section.
+ * @par Example
+ *      @code u8_t ea; HAL_INT_SAVE(ea); ... HAL_INT_RESTORE(ea); @endcode
+ *********************************************************************/
+#define HAL_INT_SAVE(STATE)     ( (STATE) = (u8_t)EA, EA = 0 )
+#define HAL_INT_RESTORE(STATE)  ( EA = (STATE) )    /*!< See \ref HAL_INT_SAVE() */
+
+/**********************************************************************
+ * @brief   Keyword of the functions called from an ISR and from the main
+ *          program while the interrupts are enabled.
+ * @details The locals and the parameters of a reentrant function are on a
+ *          stack instead of a fixed (overlaid) DATA area, so a call from an
+ *          ISR does not overwrite those of the interrupted call. With Keil
+ *          C51 in the SMALL model, the reentrant stack is set up by
+ *          STARTUP.A51 (IBPSTACK).
+ *********************************************************************/
+#if defined(HAL_SDCC)
+#define HAL_REENTRANT           __reentrant
+#else
+#define HAL_REENTRANT           reentrant
+#endif
+
+#define HAL_TIMER_INT_ENABLE()  ( ET2 = 1 )     /*!< Enable the Timer 2 interrupt only  */
+#define HAL_TIMER_INT_DISABLE() ( ET2 = 0 )     /*!< Disable the Timer 2 interrupt only */
+
+#define HAL_Idle()              ( PCON |= 0x01 ) /*!< Enter idle mode until the next interrupt */
+
+/**********************************************************************
+ * @brief   Declare a GPIO pin \c NAME connected to bit \c BIT of port \c PORT.
+ * @details On the 8051 the pin is a \c sbit, so pin accesses are single
+ *          SETB/CLR/CPL instructions.
+ * @par Example
+ *      @code HAL_PIN_DECLARE(led1Pin, 1, 3);   // Port 1 pin 3 @endcode
+ *********************************************************************/
+#if defined(HAL_SDCC)
+#define HAL_PIN_DECLARE(NAME, PORT, BIT)    __sbit __at (0x80 + ((PORT) << 4) + (BIT)) NAME   /*!< P0 is at 0x80, P1 at 0x90, ... */
+#else
+#define HAL_PIN_DECLARE(NAME, PORT, BIT)    sbit NAME = P##PORT^BIT
+#endif
+
+#define HAL_PIN_WRITE(PIN, STATE)   ( (PIN) = (STATE) )
+#define HAL_PIN_READ(PIN)           ( PIN )
+#define HAL_PIN_TOGGLE(PIN)         ( (PIN) = !(PIN) )
+
+/**********************************************************************
+ * @brief   Write the bits \c MASK of port \c PORT (0 to 3) to \c VALUE.
+ * @details The bits going low are cleared by one ANL on the port, then the
+ *          bits going high are set by one ORL. Both read-modify-write the
+ *          port latch, not the pins, so a pin pulled low by its load (a
+ *          LED, an input) does not turn a latched 1 into a 0. Each write
+ *          is a single instruction: the bits outside \c MASK are not
+ *          written, even if an interrupt changes them meanwhile. The pins
+ *          of \c MASK change within two instructions, the cleared ones
+ *          first.
+ * @note    \c PORT must be a constant (the ports are separate SFRs). It may
+ *          be a macro, it is expanded before being pasted.
+ * @par Example
+ *      @code HAL_PORT_WRITE(1, 0x07, 0x03);   // P1.0 and P1.1 high, P1.2 low @endcode
+ *********************************************************************/
+#define HAL_PORT_WRITE(PORT, MASK, VALUE)   HAL_PORT_WRITE_SFR(PORT, MASK, VALUE)
+#define HAL_PORT_WRITE_SFR(PORT, MASK, VALUE)                   \
+    ( P##PORT &= (u8_t)~( (u8_t)(MASK) & (u8_t)~(u8_t)(VALUE) ), \
+      P##PORT |= (u8_t)( (u8_t)(MASK) & (u8_t)(VALUE) ) )
+
+#elif defined(HAL_POSIX)
+/*--------------------------------------------------------------------*/
+/*                          POSIX BACKEND                             */
+/*--------------------------------------------------------------------*/
+/*!< Memory spaces have no meaning on the host */
+#define HAL_CODE
+#define HAL_DATA
+#define HAL_IDATA
+#define HAL_XDATA
+
+#define HAL_TIMER_ISR(NAME)     static void NAME(void)
+#define HAL_TIMER_ISR_USING(NAME, BANK)     static void NAME(void)
+#define HAL_TIMER_ISR_ACK()     ( (void)0 )
+#define HAL_EXT_ISR(NAME, INT)  static void NAME(void)
+
+#define HAL_TimerSetReload(RELOAD)  HAL_PosixTimerSetReload(RELOAD)
+#define HAL_TimerOverflowPending()  HAL_PosixTimerOverflowPending()
+
+#define HAL_INT_ENABLE()        HAL_PosixIntEnable()
+#define HAL_INT_DISABLE()       HAL_PosixIntDisable()
+#define HAL_INT_SAVE(STATE)     ( (STATE) = HAL_PosixIntSave() )
+#define HAL_INT_RESTORE(STATE)  HAL_PosixIntRestore(STATE)
+
+#define HAL_REENTRANT           /*!< The host compiler keeps the locals on the stack */
+
+#define HAL_TIMER_INT_ENABLE()  HAL_PosixTimerIntEnable()
+#define HAL_TIMER_INT_DISABLE() HAL_PosixTimerIntDisable()
+
+#define HAL_Idle()              HAL_PosixIdle()
+
+/*!< Number of simulated 8-bit ports (P0 to P3) */
+#define HAL_PORTS_NUM           4
+
+/*!< Simulated port latches */
+extern volatile u8_t HAL_ports[HAL_PORTS_NUM];
+
+/*!< Pin identifier: port number in bits 3..4, bit number in bits 0..2 */
+#define HAL_PIN(PORT, BIT)          ( (u8_t)( ((PORT) << 3) | (BIT) ) )
+#define HAL_PIN_PORT(PIN)           ( (PIN) >> 3 )
+#define HAL_PIN_MASK(PIN)           ( (u8_t)(1 << ((PIN) & 0x07)) )
+
+#define HAL_PIN_DECLARE(NAME, PORT, BIT)    enum { NAME = HAL_PIN(PORT, BIT) }
+
+#define HAL_PIN_WRITE(PIN, STATE)   HAL_PosixPinWrite((PIN), (STATE))
+#define HAL_PIN_READ(PIN)           ( (HAL_ports[HAL_PIN_PORT(PIN)] & HAL_PIN_MASK(PIN)) ? HIGH : LOW )
+#define HAL_PIN_TOGGLE(PIN)         HAL_PosixPinWrite((PIN), (STATE_t)!HAL_PIN_READ(PIN))
+
+#define HAL_PORT_WRITE(PORT, MASK, VALUE)   HAL_PortWrite((PORT), (MASK), (VALUE))
+
+void HAL_PosixTimerSetReload(const u16_t reload);
+BOOL_t HAL_PosixTimerOverflowPending(void);
+void HAL_PosixIntEnable(void);
+void HAL_PosixIntDisable(void);
+u8_t HAL_PosixIntSave(void);
+void HAL_PosixIntRestore(const u8_t state);
+void HAL_PosixTimerIntEnable(void);
+void HAL_PosixTimerIntDisable(void);
+void HAL_PosixIdle(void);
+void HAL_PosixPinWrite(const u8_t pin, const STATE_t state);
+
+#endif
+
+
+
+/*--------------------------------------------------------------------*/
+/*                          API FUNCTIONS                             */
+/*--------------------------------------------------------------------*/
+/***************************************************************************
+ * @brief   Configure Timer 2 in 16-bit auto-reload mode and start it.
+ * @param[in] \c reload: Reload value. Timer 2 overflows every (65536 - reload)
+ *            increments. See \ref HAL_TIMER_RELOAD.
+ * @param[in] \c isr: The Timer 2 overflow ISR defined by \ref HAL_TIMER_ISR.
+ *            On the 8051 the ISR is bound by its interrupt vector, so this
+ *            parameter is only used by the POSIX backend.
+ * @note    Enables the Timer 2 interrupt and the global interrupts.
+ ***************************************************************************/
+void HAL_TimerStart(const u16_t reload, void (* const isr)(void));
+
+/***************************************************************************
+ * @brief   Stop Timer 2.
+ ***************************************************************************/
+void HAL_TimerStop(void);
+
+/***************************************************************************
+ * @brief   Read the running count of Timer 2 (TH2:TL2).
+ * @details The count goes up from the reload value to 65535, then
+ *          overflows. The high byte is read again after the low byte, so
+ *          a carry between the two reads cannot tear the value.
+ *          Reentrant: it is called by the ISR and by the tasks with the
+ *          interrupts enabled.
+ * @return  \c u16_t: The Timer 2 count.
+ ***************************************************************************/
+u16_t HAL_TimerRead(void) HAL_REENTRANT;
+
+/***************************************************************************
+ * @brief   Enable the external interrupt \c number, on the falling edge of its pin.
+ * @param[in] \c number: 0 for INT0 (P3.2), 1 for INT1 (P3.3). Other values
+ *            are ignored.
+ * @param[in] \c isr: The ISR defined by \ref HAL_EXT_ISR. On the 8051 the
+ *            ISR is bound by its interrupt vector, so this parameter is only
+ *            used by the POSIX backend (\c SIGUSR1 is INT0, \c SIGUSR2 is INT1).
+ * @note    Some 8051 derivatives only leave power-down mode on a low level
+ *          of the pin: then clear IT0/IT1 after this call, and let the ISR
+ *          disable its interrupt until the pin is high again.
+ ***************************************************************************/
+void HAL_ExtIntEnable(const u8_t number, void (* const isr)(void));
+
+/***************************************************************************
+ * @brief   Enable the interrupts and enter power-down mode until an
+ *          external interrupt.
+ * @details The interrupts are enabled by the instruction right before the
+ *          one entering power-down, and the 8051 runs that one before any
+ *          interrupt: an interrupt raised after the caller decided to
+ *          power down wakes the CPU up instead of being lost. The ISR of
+ *          the external interrupt runs before this function returns.
+ * @note    To be called with the interrupts disabled. Every clock stops in
+ *          power-down, Timer 2 included: it goes on from the same count.
+ * @return  \c u32_t: Time spent in power-down in ms, if the backend can
+ *          measure it. On the 8051, the time from \ref HAL_SleepClockRead()
+ *          with \ref HAL_CFG_SLEEP_CLOCK, else 0: the classic 8051 has no
+ *          clock running in power-down.
+ ***************************************************************************/
+u32_t HAL_PowerDown(void);
+
+#if HAL_CFG_SLEEP_CLOCK
+/***************************************************************************
+ * @brief   Start measuring a power-down (\ref HAL_CFG_SLEEP_CLOCK).
+ * @details Implemented by the application, with a clock that runs in
+ *          power-down (e.g. latch an RTC, or clear the count of a wake-up
+ *          timer). Called by \ref HAL_PowerDown() with the interrupts
+ *          disabled, right before power-down.
+ ***************************************************************************/
+void HAL_SleepClockStart(void);
+
+/***************************************************************************
+ * @brief   Time since \ref HAL_SleepClockStart() in ms (\ref HAL_CFG_SLEEP_CLOCK).
+ * @details Implemented by the application. Called by \ref HAL_PowerDown()
+ *          after the wake-up, once the ISR of the external interrupt ran.
+ ***************************************************************************/
+u32_t HAL_SleepClockRead(void);
+#endif
+
+/***************************************************************************
+ * @brief   Write the bits \c mask of port \c port to \c value.
+ * @details Like \ref HAL_PORT_WRITE, for a port number known at run time
+ *          (e.g. read from a pin map).
+ * @param[in] \c port: Port number, 0 to 3. Other values are ignored.
+ * @param[in] \c mask: Bits of the port to write.
+ * @param[in] \c value: Value of the bits (the bits outside \c mask are ignored).
+ ***************************************************************************/
+void HAL_PortWrite(const u8_t port, const u8_t mask, const u8_t value);
+
+#endif  /* HAL_H */
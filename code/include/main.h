@@ -32,7 +32,9 @@
 /*-------------------------------------------------------------*/
 /* SHOULD NOT NEED TO EDIT THE SECTIONS BELOW                  */
 /*-------------------------------------------------------------*/
-/* Interrupts number of Timers overflow from the vector table of the 8051 */
+/* Interrupts number of external interrupts and Timers overflow from the vector table of the 8051 */
+#define INTERRUPT_External_0                0
+#define INTERRUPT_External_1                2
 #define INTERRUPT_Timer_0_Overflow          1
 #define INTERRUPT_Timer_1_Overflow          3
 #define INTERRUPT_Timer_2_Overflow          5
@@ -12,17 +12,30 @@
 /**********************************************************************
  * In file traffic.C 
  *********************************************************************/
-sbit redPin     = P1^0;   /* Port 1 pin 0 */
-sbit amberPin   = P1^1;   /* Port 1 pin 1 */
-sbit greenPin   = P1^2;   /* Port 1 pin 2 */
+/*!< Lamps of each intersection: port number and bit masks (the 3 lamps on one port) */
+#define TRAFFIC_0_PORT      1
+#define TRAFFIC_0_RED       0x01    /* Port 1 pin 0 */
+#define TRAFFIC_0_AMBER     0x02    /* Port 1 pin 1 */
+#define TRAFFIC_0_GREEN     0x04    /* Port 1 pin 2 */
+
+/*!< Port 2 is free when the XDATA memory is on-chip */
+#define TRAFFIC_1_PORT      2
+#define TRAFFIC_1_RED       0x01    /* Port 2 pin 0 */
+#define TRAFFIC_1_AMBER     0x02    /* Port 2 pin 1 */
+#define TRAFFIC_1_GREEN     0x04    /* Port 2 pin 2 */
+
+#define TRAFFIC_2_PORT      2
+#define TRAFFIC_2_RED       0x08    /* Port 2 pin 3 */
+#define TRAFFIC_2_AMBER     0x10    /* Port 2 pin 4 */
+#define TRAFFIC_2_GREEN     0x20    /* Port 2 pin 5 */
 
 /**********************************************************************
  * In file main.C 
  *********************************************************************/
-sbit led1Pin = P1^3;
-sbit led2Pin = P1^4;
-sbit led3Pin = P1^5;
-sbit motorPin = P1^6;
-sbit buzzerPin = P1^7;
+HAL_PIN_DECLARE(led1Pin,   1, 3);
+HAL_PIN_DECLARE(led2Pin,   1, 4);
+HAL_PIN_DECLARE(led3Pin,   1, 5);
+HAL_PIN_DECLARE(motorPin,  1, 6);
+HAL_PIN_DECLARE(buzzerPin, 1, 7);
 
 #endif  /* _PORT_H */
\ No newline at end of file
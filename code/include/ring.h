@@ -0,0 +1,161 @@
+/***************************************************************************
+ * @file    ring.h
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Lock-free single-producer/single-consumer ring buffer, to pass
+ *          data from an interrupt to a task (or from a task to an interrupt).
+ * @details The ring has one writer of each index:
+ *          - The producer only writes the head, after the element is stored.
+ *          - The consumer only writes the tail, after the element is read.
+ *          The indices are 8-bit, so each one is read and written in a
+ *          single access on the 8051, and neither side has to disable the
+ *          interrupts (EA). The indices run freely from 0 to 255 and are
+ *          masked by the size, which must be a power of two up to 128. The
+ *          number of elements is head - tail, modulo 256.
+ *
+ *          The ring is a set of macros, not functions: each side gets its
+ *          own copy of the code, inline in the ISR or the task, with no
+ *          function of its own called from both, so the linker has no
+ *          locals to overlay between them (no L15 warning with Keil C51).
+ *          The type of the elements is chosen by the user.
+ * @note    Only one producer and one consumer: two tasks putting to the
+ *          same ring must not preempt each other (with cooperative tasks,
+ *          they do not).
+ * @par Example
+ * @code
+ *          RING_DECLARE(rxRing, u8_t, 16);     // 16 bytes, in XDATA
+ *
+ *          void UART_ISR(void) interrupt 4 {   // Producer
+ *              ERROR_t error = ERROR_NO;
+ *              RING_PUT(rxRing, SBUF, error);  // Full: the byte is dropped
+ *              RI = 0;
+ *          }
+ *
+ *          ERROR_t UART_Update(void) {         // Consumer, a cuteOS task
+ *              u8_t byte;
+ *              while(!RING_IS_EMPTY(rxRing)) {
+ *                  RING_GET(rxRing, byte);
+ *                  // ...
+ *              }
+ *              return ERROR_NO;
+ *          }
+ * @endcode
+ * @version 1.0.0
+ * @date    2022-05-10
+ * @copyright Copyright (c) 2022
+ ***************************************************************************/
+#ifndef RING_H
+#define RING_H
+
+#include "STD_TYPES.h"
+#include "hal.h"
+
+/***************************************************************************
+ * @brief   Indices of a ring. Declared as a member of the ring by
+ *          \ref RING_DECLARE(), not used directly.
+ ***************************************************************************/
+typedef struct {
+    u8_t head;          /*!< Next element to put, written by the producer only */
+    u8_t tail;          /*!< Next element to get, written by the consumer only */
+    u8_t dropped;       /*!< Elements not put because the ring was full, written by the producer only */
+} RING_INDICES_t;
+
+/***************************************************************************
+ * @brief   SIZE if it is a valid ring size, -1 (a compilation error as an
+ *          array size) otherwise.
+ ***************************************************************************/
+#define RING_CHECK_SIZE(SIZE)   \
+    ( ( ((SIZE) >= 2) && ((SIZE) <= 128) && (0 == ((SIZE) & ((SIZE) - 1))) ) ? (SIZE) : -1 )
+
+/***************************************************************************
+ * @brief   Declare a ring in XDATA.
+ * @param[in] NAME: Name of the ring variable.
+ * @param[in] TYPE: Type of the elements.
+ * @param[in] SIZE: Number of elements, a power of two from 2 to 128.
+ *            Checked at compile time.
+ * @note    Prefix with static to make the ring private to its file (the
+ *          ISR and the task of a driver are usually in the same file). The
+ *          ring must be zeroed before use, as all static variables are at
+ *          startup (or by \ref RING_RESET()).
+ ***************************************************************************/
+#define RING_DECLARE(NAME, TYPE, SIZE)                                      \
+    volatile struct {                                                       \
+        RING_INDICES_t idx;                                                 \
+        TYPE buffer[RING_CHECK_SIZE(SIZE)];                                 \
+    } HAL_XDATA NAME
+
+/***************************************************************************
+ * @brief   Number of elements a ring can hold.
+ ***************************************************************************/
+#define RING_SIZE(RING)         ( (u8_t)(sizeof((RING).buffer) / sizeof((RING).buffer[0])) )
+
+/***************************************************************************
+ * @brief   Number of elements in a ring, from 0 to \ref RING_SIZE().
+ * @note    Exact for the side that calls it: the other side can only make
+ *          it larger (for the consumer) or smaller (for the producer).
+ ***************************************************************************/
+#define RING_COUNT(RING)        ( (u8_t)((RING).idx.head - (RING).idx.tail) )
+
+/***************************************************************************
+ * @brief   TRUE if there is no element to get.
+ ***************************************************************************/
+#define RING_IS_EMPTY(RING)     ( (RING).idx.head == (RING).idx.tail )
+
+/***************************************************************************
+ * @brief   TRUE if there is no room to put an element.
+ ***************************************************************************/
+#define RING_IS_FULL(RING)      ( RING_COUNT(RING) >= RING_SIZE(RING) )
+
+/***************************************************************************
+ * @brief   Number of elements dropped because the ring was full, since
+ *          the last \ref RING_RESET(). Saturates at 255.
+ ***************************************************************************/
+#define RING_DROPPED(RING)      ( (RING).idx.dropped )
+
+/***************************************************************************
+ * @brief   Put an element. Producer side only.
+ * @param[in] RING: The ring.
+ * @param[in] VALUE: The element.
+ * @param[out] ERROR: An \ref ERROR_t variable, ORed with \ref ERROR_BUSY if
+ *             the ring is full. The element is dropped then.
+ * @details The element is stored before the head moves, so the consumer
+ *          never sees an element that is not written yet.
+ ***************************************************************************/
+#define RING_PUT(RING, VALUE, ERROR)                                        \
+    do {                                                                    \
+        if(RING_IS_FULL(RING)) {                                            \
+            if((RING).idx.dropped < 0xFF) {                                 \
+                ++(RING).idx.dropped;                                       \
+            }                                                               \
+            (ERROR) |= ERROR_BUSY;                                          \
+        } else {                                                            \
+            (RING).buffer[(RING).idx.head & (u8_t)(RING_SIZE(RING) - 1)] = (VALUE); \
+            (RING).idx.head = (u8_t)((RING).idx.head + 1);                  \
+        }                                                                   \
+    } while(0)
+
+/***************************************************************************
+ * @brief   Get the oldest element. Consumer side only.
+ * @param[in] RING: The ring, must not be empty (see \ref RING_IS_EMPTY()).
+ * @param[out] VARIABLE: Variable that takes the element.
+ * @details The element is read before the tail moves, so the producer
+ *          never overwrites an element that is not read yet.
+ ***************************************************************************/
+#define RING_GET(RING, VARIABLE)                                            \
+    do {                                                                    \
+        (VARIABLE) = (RING).buffer[(RING).idx.tail & (u8_t)(RING_SIZE(RING) - 1)]; \
+        (RING).idx.tail = (u8_t)((RING).idx.tail + 1);                      \
+    } while(0)
+
+/***************************************************************************
+ * @brief   Empty a ring and clear its dropped counter.
+ * @note    Neither side must use the ring meanwhile (e.g. call it before
+ *          enabling the interrupt of the producer).
+ ***************************************************************************/
+#define RING_RESET(RING)                                                    \
+    do {                                                                    \
+        (RING).idx.head = 0;                                                \
+        (RING).idx.tail = 0;                                                \
+        (RING).idx.dropped = 0;                                             \
+    } while(0)
+
+#endif /* RING_H */
@@ -9,9 +9,19 @@
 #ifndef TRAFFIC_H
 #define TRAFFIC_H
 
+/*--------------------------------------------------------------------*/
+/*                          DEFINITIONS                               */
+/*--------------------------------------------------------------------*/
+/*!< Lamps of a phase, mapped to the pins of each intersection by \ref TRAFFIC_PINS_t */
+#define TRAFFIC_LAMP_RED        0x01
+#define TRAFFIC_LAMP_AMBER      0x02
+#define TRAFFIC_LAMP_GREEN      0x04
+
+
 /*--------------------------------------------------------------------*/
 /*                          TYPE DEFINITIONS                          */
 /*--------------------------------------------------------------------*/
+/*!< Phases of the day sequence, their index in \ref TRAFFIC_PhasesDay */
 typedef enum {
     RED,
     RED_AMBER,
@@ -19,6 +29,39 @@ typedef enum {
     AMBER
 }TRAFFIC_SEQUENCE_t;
 
+/***************************************************************************
+ * @brief   One phase of a traffic light sequence.
+ * @details A sequence is a constant table of phases in CODE memory, see
+ *          \ref TRAFFIC_SetPhases().
+ ***************************************************************************/
+typedef struct {
+    u8_t  lamps;        /*!< Lamps lit during the phase, \ref TRAFFIC_LAMP_RED, ... */
+    u8_t  next;         /*!< Index of the next phase in the same table */
+    u16_t duration_ms;  /*!< Duration of the phase in ms (1 to 65535) */
+}TRAFFIC_PHASE_t;
+
+/***************************************************************************
+ * @brief   Pins of the lamps of one intersection.
+ * @details The three lamps must be on the same port, so they change with
+ *          one write.
+ ***************************************************************************/
+typedef struct {
+    u8_t port;          /*!< Port number, 0 to 3 */
+    u8_t red;           /*!< Bit mask of the red lamp in the port */
+    u8_t amber;         /*!< Bit mask of the amber lamp in the port */
+    u8_t green;         /*!< Bit mask of the green lamp in the port */
+}TRAFFIC_PINS_t;
+
+/***************************************************************************
+ * @brief   Configuration of one intersection, see \ref TRAFFIC_Intersections.
+ ***************************************************************************/
+typedef struct {
+    TRAFFIC_PINS_t pins;                        /*!< Pins of the lamps */
+    const TRAFFIC_PHASE_t HAL_CODE * phases;    /*!< Sequence at start-up */
+    u8_t  count;                                /*!< Number of phases of the sequence */
+    u16_t offset_ms;    /*!< Delay of the sequence from the start, e.g. the travel time from the previous intersection for a green wave */
+}TRAFFIC_INTERSECTION_t;
+
 
 
 
@@ -27,7 +70,11 @@ typedef enum {
 /*--------------------------------------------------------------------*/
 
 /***************************************************************************
- * @brief   Initialize the traffic light system to RED state.
+ * @brief   Initialize all the intersections to the first phase of their
+ *          sequence (\ref RED for the day sequence).
+ * @details The first phase of each intersection lasts its \c offset_ms
+ *          more, so the sequences of the intersections are shifted by
+ *          their offsets.
  * @return \c ERROR_t: Check the options in the global enum \ref ERROR_t.
  ***************************************************************************/
 ERROR_t TRAFFIC_Init(void);
@@ -38,22 +85,46 @@ ERROR_t TRAFFIC_Init(void);
  ***************************************************************************/
 ERROR_t TRAFFIC_DeInit(void);
 
+/***************************************************************************
+ * @brief   Go to the next phase of the intersections whose phase ended.
+ * @details Called by the one-shot software timer, at the nearest end of
+ *          phase of all the intersections, not periodically.
+ * @return \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ ***************************************************************************/
 ERROR_t TRAFFIC_Update(void);
 
 /***************************************************************************
- * @brief   Set the traffic light color sequence to the given color sequence.
+ * @brief   Run another sequence of phases on an intersection, from its first phase.
+ * @param[in] Copy_id: The intersection, 0 to TRAFFIC_INTERSECTIONS - 1.
+ * @param[in] Copy_phases: The table of phases, in CODE memory.
+ * @param[in] Copy_count: The number of phases in the table.
+ * @return \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          \ref ERROR_ILLEGAL_PARAM if a phase has no duration or a next
+ *          phase out of the table.
+ * @par Example
+ *      @code TRAFFIC_SetPhases(0, TRAFFIC_PhasesNight, TRAFFIC_NIGHT_PHASES);   // Flashing amber @endcode
+ ***************************************************************************/
+ERROR_t TRAFFIC_SetPhases(const u8_t Copy_id, const TRAFFIC_PHASE_t HAL_CODE * const Copy_phases, const u8_t Copy_count);
+
+/***************************************************************************
+ * @brief   Set the traffic light color sequence of an intersection to the
+ *          given color sequence.
+ * @param[in] Copy_id: The intersection, 0 to TRAFFIC_INTERSECTIONS - 1.
  * @param[in] color sequence: The color sequence to set:
  *          - \ref RED
  *          - \ref RED_AMBER
  *          - \ref GREEN
  *          - \ref AMBER
  *          Those colors are members of the global enumeration \ref TRAFFIC_SEQUENCE_t.
+ *          With another table (\ref TRAFFIC_SetPhases()), it is the index
+ *          of the phase.
  * @return \c ERROR_t: Check the options in the global enum \ref ERROR_t.
  ***************************************************************************/
-ERROR_t TRAFFIC_SetColor(const TRAFFIC_SEQUENCE_t Copy_color);
+ERROR_t TRAFFIC_SetColor(const u8_t Copy_id, const TRAFFIC_SEQUENCE_t Copy_color);
 
 /***************************************************************************
- * @brief   Get the traffic light color sequence.
+ * @brief   Get the traffic light color sequence of an intersection.
+ * @param[in] Copy_id: The intersection, 0 to TRAFFIC_INTERSECTIONS - 1.
  * @param[out] Copy_color: pointer to the variable to store the color sequence.
  *          Expected values:
  *          - \ref RED
@@ -61,9 +132,11 @@ ERROR_t TRAFFIC_SetColor(const TRAFFIC_SEQUENCE_t Copy_color);
  *          - \ref GREEN
  *          - \ref AMBER
  *          Those colors are members of the global enumeration \ref TRAFFIC_SEQUENCE_t.
+ *          With another table (\ref TRAFFIC_SetPhases()), it is the index
+ *          of the phase.
  * @return \c ERROR_t: Check the options in the global enum \ref ERROR_t.
  ***************************************************************************/
-ERROR_t TRAFFIC_GetColor(TRAFFIC_SEQUENCE_t * const Copy_color);
+ERROR_t TRAFFIC_GetColor(const u8_t Copy_id, TRAFFIC_SEQUENCE_t * const Copy_color);
 
 
-#endif          /* TRAFFIC_H */
\ No newline at end of file
+#endif          /* TRAFFIC_H */
@@ -19,6 +19,11 @@ typedef enum {
     TRAFFIC_DURATION_AMBER = 2,         /*!< Amber light duration in seconds */
 }TRAFFIC_SEQUENCE_DURATION_t;
 
+#define TRAFFIC_FLASH_MS        500     /*!< On and off durations of the flashing amber, in ms */
+
+#define TRAFFIC_INTERSECTIONS   3       /*!< Number of intersections (1 to 255), see \ref TRAFFIC_Intersections */
+#define TRAFFIC_WAVE_MS         2000    /*!< Travel time between two intersections of the corridor, in ms (green wave) */
+
 
 
 
@@ -26,13 +31,11 @@ typedef enum {
 /*-------------------------------------------------------------------------*/
 /*                YOU MUST <<<NOT>>> CHANGE THE FOLLOWING PARAMETERS	   */
 /*-------------------------------------------------------------------------*/
-typedef struct {
-    TRAFFIC_SEQUENCE_DURATION_t red_duration;
-    TRAFFIC_SEQUENCE_DURATION_t red_amber_duration;
-    TRAFFIC_SEQUENCE_DURATION_t green_duration;
-    TRAFFIC_SEQUENCE_DURATION_t amber_duration;
-}TRAFFIC_CONFIGS_t;
+#define TRAFFIC_DAY_PHASES      4       /*!< Phases of \ref TRAFFIC_PhasesDay, see \ref TRAFFIC_SEQUENCE_t */
+#define TRAFFIC_NIGHT_PHASES    2       /*!< Phases of \ref TRAFFIC_PhasesNight */
 
-extern TRAFFIC_CONFIGS_t TRAFFIC_Configs;
+extern const TRAFFIC_PHASE_t HAL_CODE TRAFFIC_PhasesDay[TRAFFIC_DAY_PHASES];
+extern const TRAFFIC_PHASE_t HAL_CODE TRAFFIC_PhasesNight[TRAFFIC_NIGHT_PHASES];
+extern const TRAFFIC_INTERSECTION_t HAL_CODE TRAFFIC_Intersections[TRAFFIC_INTERSECTIONS];
 
-#endif /* TRAFFIC_CFG_H */
\ No newline at end of file
+#endif /* TRAFFIC_CFG_H */
@@ -6,7 +6,9 @@
  *          It invokes te scheduler (\ref cuteOS_ISR()) periodically by Timer 
  *          overflow. So, the timing of the tasks is determined by the 
  * 			frequency of Timer overflow defined by the variable \ref cuteOS_TICK_TIME.
- * @note    cuteOS uses the timer2 for scheduling.
+ * @note    cuteOS uses the timer2 for scheduling. The timer, interrupts and
+ *          idle mode are accessed through the HAL (\ref hal.h), so the
+ *          kernel also runs natively on a POSIX host.
  * @version 1.1.0
  * @date    2022-03-22
  * @copyright Copyright (c) 2022
@@ -15,62 +17,512 @@
  *              1. Initialize the Cute OS.
  *                  @code cuteOS_Init();    @endcode
  *              2. Initialize the tasks.
- *                  @code cuteOS_TaskCreate(task1, 1000); // task1 will run every 1 second  @endcode
- *                  @code cuteOS_TaskCreate(task2, 2000); // task2 will run every 2 seconds @endcode
+ *                  @code cuteOS_TaskCreate(task1, CUTEOS_MS(1000), 0, NULL); // task1 will run every 1 second, highest priority @endcode
+ *                  @code cuteOS_TaskCreate(task2, CUTEOS_MS(2000), CUTEOS_PRIO_AUTO, &task2_handle); // task2 will run every 2 seconds @endcode
  *              3. Start the Cute OS scheduler.
  *                  @code cuteOS_Start();   @endcode
  *********************************************************************/
-#include <reg52.h>
 #include "STD_TYPES.h"
-#include "main.H"
+#include "main.h"
+#include "hal.h"
+#include "cuteOS_cfg.h"
 #include "cuteOS.h"
 
+#if CUTEOS_CFG_STATIC
+#include "cuteOS_tasks_cfg.h"
+
+#if CUTEOS_CFG_HYBRID
+#error "The static task set (CUTEOS_CFG_STATIC) does not support the preemptive task (CUTEOS_CFG_HYBRID)"
+#endif
+#endif
+
+#if (0 == CUTEOS_CFG_TIME_UNIT_US) || ((1000 % CUTEOS_CFG_TIME_UNIT_US) != 0)
+#error "The time unit (CUTEOS_CFG_TIME_UNIT_US) must be a divisor of 1000 us"
+#endif
+
+#if CUTEOS_ISR_BANKED && defined(__C51__)
+/*!< The ISR runs on its own register bank, the functions it calls must not use bank 0 absolute registers */
+#pragma NOAREGS
+#endif
+
 /*--------------------------------------------------------------------*/
 /* PRIVATE FUNCTIONS DECLARATION                                      */
 /*--------------------------------------------------------------------*/
-static ERROR_t cuteOS_SetTickTime(const u8_t TICK_TIME_MS);
+#if CUTEOS_CFG_STATIC
+static void cuteOS_StaticLoad(void);
+#else
+static u8_t cuteOS_TaskAlloc(ERROR_t (* const callback)(void), const u32_t PERIOD, const u8_t PRIORITY, const u32_t OFFSET);
+static ERROR_t cuteOS_SetTickTime(const u32_t TICK_TIME);
 static ERROR_t cuteOS_GCD(u32_t *gcd);
 static ERROR_t cuteOS_UpdateTicks(void);
+static ERROR_t cuteOS_TickFit(const u32_t TIME);
+static void cuteOS_TickSwitch(const u16_t TICK_TIME);
+static void cuteOS_TaskSchedule(const u8_t index);
+#if CUTEOS_CFG_ADMISSION
+static ERROR_t cuteOS_Admit(const u8_t index, const u32_t PERIOD);
+static u32_t cuteOS_AdmitOffset(const u8_t i, const u8_t index);
+#endif
+#endif
+static void cuteOS_Dispatch(void);
+static void cuteOS_ReadyAppend(const u8_t index);
+static void cuteOS_ReadyUnlink(const u8_t index);
+static void cuteOS_UpdatePriorities(void);
+#if !CUTEOS_CFG_STATIC || CUTEOS_CFG_BALANCE
+static u32_t cuteOS_GCD2(u32_t x, u32_t y);
+#endif
+#if CUTEOS_CFG_BALANCE
+static void cuteOS_Balance(void);
+#endif
+static void cuteOS_WheelInsert(const u8_t index);
+static void cuteOS_WheelUnlink(const u8_t index);
+static void cuteOS_WheelExpire(void);
+#if CUTEOS_CFG_TICKLESS
+static u8_t cuteOS_WheelNextStep(const u16_t running);
+#endif
+static u16_t cuteOS_ReadTime(u32_t * const ptr_ticks);
+static u32_t cuteOS_CoroNow(void);
+#if CUTEOS_CFG_TIMERS
+static u8_t cuteOS_TimerFind(ERROR_t (* const callback)(void));
+static void cuteOS_TimerArm(const u8_t index);
+static void cuteOS_TimerInsert(const u8_t index);
+static void cuteOS_TimerUnlink(const u8_t index);
+static void cuteOS_TimerExpire(void);
+static void cuteOS_TimerRun(void);
+static u32_t cuteOS_TimerTicks(const u32_t TIME);
+#if !CUTEOS_CFG_STATIC
+static void cuteOS_TimerRescale(const u16_t OLD_TICK_TIME);
+#endif
+#endif
+#if CUTEOS_CFG_EVENTS
+static void cuteOS_EventUnlink(const u8_t index);
+#endif
+#if CUTEOS_CFG_TASK_STATS || CUTEOS_CFG_LOAD_STATS || CUTEOS_CFG_TRACE
+static u32_t cuteOS_Timestamp(void);
+#endif
+#if CUTEOS_CFG_TASK_STATS
+static void cuteOS_StatsUpdate(const u8_t index, const u32_t cycles);
+#endif
+#if CUTEOS_CFG_LOAD_STATS
+static void cuteOS_LoadUpdate(const u32_t now, const u32_t idle_cycles);
+#endif
+#if CUTEOS_CFG_POWER_DOWN
 static void cuteOS_Sleep(void);
-static void cuteOS_ISR();
+static BOOL_t cuteOS_PowerDownDue(void);
+static void cuteOS_PowerResync(const u32_t SLEPT_MS);
+#endif
+#if !defined(HAL_SDCC)
+static void cuteOS_ISR(void);   /*!< With SDCC, the prototype is in \ref cuteOS.h */
+#endif
 
 
 /*--------------------------------------------------------------------*/
 /*                          PRIVATE DATA                              */
 /*--------------------------------------------------------------------*/
 /**********************************************************************
- * @brief   Maximum tick time in milliseconds.
- * @details This variable is used to set the maximum tick time in milliseconds.
- *          The maximum tick time is used to set the maximum time of the tasks.
- *          It has a maximum value of 65 ms because:
- *          1. The maximum value of the timer 2 is 65535 (16-bit timer).
- *          2. The 8051 microcontroller has 1 MIPS (1 million instructions per second),
- *             with 12MHz clock, and 12 clock cycles per instruction.
- *          So, the maximum tick time = (65535 * 12) / 12000000 = 65 ms. 
+ * @brief   Timer 2 increments in \c T time units (\ref CUTEOS_CFG_TIME_UNIT_US).
+ * @details Timer 2 is incremented once every instruction cycle, so:
+ *          increments = T * (unit in us) * (OSC_FREQ / 10^6) / OSC_PER_INST.
+ *          Computed in 32 bits for any tick time up to \ref CUTEOS_MAX_TICK_TIME.
  *********************************************************************/
-#define MAX_TICK_TIME_MS  65         
+#define TICK_INCREMENTS(T)  ( (u16_t)( ((u32_t)(T) * ((u32_t)CUTEOS_CFG_TIME_UNIT_US * (OSC_FREQ / 1000UL))) / (1000UL * (u32_t)OSC_PER_INST) ) )
+
+/*!< Number of time units in one ms */
+#define UNITS_PER_MS        ( 1000UL / CUTEOS_CFG_TIME_UNIT_US )
+
+/*!< Timer 2 increments left before the overflow needed to write both reload registers, see cuteOS_TickSwitch(). */
+#define RELOAD_MARGIN_INC   32
+
+#if CUTEOS_CFG_STATIC
+/*!< Tick time in time units, given with the task set (\ref CUTEOS_CFG_STATIC_TICK) */
+#define CUTEOS_STATIC_TICK          ( (u16_t)(CUTEOS_CFG_STATIC_TICK) )
+
+/*!< Timer 2 increments in one tick */
+#define CUTEOS_STATIC_INCREMENTS    TICK_INCREMENTS(CUTEOS_STATIC_TICK)
 
-/*!< Tick time in ms (must be less than MAX_TICK_TIME_MS). */
-static u8_t cuteOS_tick_time_ms = 0; 
+/*!< Tick time in time units. */
+static u16_t cuteOS_tick_time = CUTEOS_STATIC_TICK;
+#else
+/*!< Tick time in time units (at most CUTEOS_MAX_TICK_TIME), 0 until computed. */
+static u16_t cuteOS_tick_time = 0; 
+#endif
 
 /*!< Number of ticks, which is incremented by 1 at each Timer 2 overflow. */
-static u16_t cuteOS_tick_count = 0;
+static volatile u32_t cuteOS_tick_count = 0;
 
-#define MAX_TASKS_NUM   8
+#if !CUTEOS_CFG_STATIC
+/*!< TRUE after cuteOS_Start(): the tasks created or changed are scheduled at once. */
+static BOOL_t cuteOS_started = FALSE;
+
+/*!< Tick count the offsets of the tasks are counted from, set by cuteOS_UpdateTicks(). */
+static u32_t cuteOS_origin = 0;
+#endif
+
+#if CUTEOS_CFG_STATIC
+#define CUTEOS_STATIC_COUNT(CALLBACK, PERIOD, PRIORITY)     + 1
+#define MAX_TASKS_NUM   ( 0 CUTEOS_CFG_STATIC_TASKS(CUTEOS_STATIC_COUNT) )    /*!< The tasks array holds the static task set only */
+#else
+#define MAX_TASKS_NUM   CUTEOS_CFG_MAX_TASKS
+#endif
+
+#define TASK_NONE       0xFF    /*!< Invalid task index, ends the lists of tasks */
 
 /*!< Number of tasks created by the user. */
 static u8_t cuteOS_task_counter = 0;         /*!< Counter for the number of tasks created */
 
+/**********************************************************************
+ * @brief   Free slots of the tasks array.
+ * @details The slots below \ref cuteOS_task_top were used at least once:
+ *          the free ones are linked by the task member \c next (a free
+ *          task is not in the timing wheel) from \ref cuteOS_task_free.
+ *          The slots from \ref cuteOS_task_top up were never used. So, a
+ *          slot is found and released in constant time, and the array
+ *          needs no initialization.
+ *********************************************************************/
+static u8_t cuteOS_task_free = TASK_NONE;
+static u8_t cuteOS_task_top = 0;
+
 /*!< Task Information Structure. */
 typedef struct {
     ERROR_t (*callback)(void);    /*!< Pointer to the task function */
-    u32_t delay_ms;                    /*!< Delay in ms */
-    u16_t ticks;    /*!< Number of ticks after which the task will run */
+    u32_t period;   /*!< Period in time units (ms by default) */
+    u32_t offset;   /*!< Release offset in time units, or \ref CUTEOS_OFFSET_AUTO */
+    u32_t ticks;    /*!< Number of ticks after which the task will run (period) */
+    u32_t phase;    /*!< Release offset in ticks, 0 to ticks - 1 */
+    u32_t expiry;   /*!< Tick count of the next run */
+    u8_t  next;     /*!< Next task in the same timing wheel slot */
+    u8_t  prev;     /*!< Previous task in the same timing wheel slot */
+    u8_t  slot;     /*!< Timing wheel slot the task is linked in, or \ref TASK_NONE */
+    u8_t  ready_next;   /*!< Next task in the same priority ready list */
+    u8_t  ready_prev;   /*!< Previous task in the same priority ready list */
+    u8_t  suspended;    /*!< TRUE while the task is suspended by \ref cuteOS_TaskSuspend() */
+    u8_t  base_priority;    /*!< Priority given at creation, may be \ref CUTEOS_PRIO_AUTO */
+    u8_t  priority;     /*!< Effective priority, 0 (highest) to 7 (lowest) */
     u8_t  id;       /*!< Task ID */    
+#if CUTEOS_CFG_EVENTS
+    u8_t  event_mask;   /*!< Events the task waits on, 0 for a periodic task */
+    u8_t  events;       /*!< Events set since the last run of the task */
+    u8_t  event_next;   /*!< Next task in the list of the event tasks */
+    u8_t  event_prev;   /*!< Previous task in the list of the event tasks */
+#endif
+#if CUTEOS_CFG_TASK_STATS
+    cuteOS_TASK_STATS_t stats;  /*!< Execution time statistics */
+#endif
+#if CUTEOS_CFG_ADMISSION
+    u16_t wcet_us;      /*!< Worst-case execution time budget in us, 0: none */
+#endif
 }cuteOS_TASK_t;
 
-/*!< Tasks array containing tasks information. */
-cuteOS_TASK_t tasks[MAX_TASKS_NUM] = {0};
+/*!< Tasks array containing tasks information, in XDATA to scale past the DATA memory. */
+cuteOS_TASK_t HAL_XDATA tasks[MAX_TASKS_NUM] = {0};
+
+#if CUTEOS_CFG_STATIC
+/*!< Constant part of a task of the static task set. */
+typedef struct {
+    ERROR_t (*callback)(void);  /*!< Pointer to the task function */
+    u32_t period;               /*!< Period in time units */
+    u32_t ticks;                /*!< Period in ticks */
+    u8_t  priority;             /*!< Priority, may be \ref CUTEOS_PRIO_AUTO */
+}cuteOS_STATIC_TASK_t;
+
+#define CUTEOS_STATIC_ENTRY(CALLBACK, PERIOD, PRIORITY)     \
+    { CALLBACK, (PERIOD), (u32_t)(PERIOD) / CUTEOS_STATIC_TICK, (PRIORITY) },
+
+/*!< The static task set, computed by the compiler and stored in CODE memory. */
+static const cuteOS_STATIC_TASK_t HAL_CODE cuteOS_static_tasks[MAX_TASKS_NUM] = {
+    CUTEOS_CFG_STATIC_TASKS(CUTEOS_STATIC_ENTRY)
+};
+
+/*!< Compile-time checks: the number of tasks, the priorities, the tick time and the periods */
+#define CUTEOS_STATIC_BAD_PRIO(CALLBACK, PERIOD, PRIORITY)  \
+    + ( ((PRIORITY) >= CUTEOS_PRIO_LEVELS) && ((PRIORITY) != CUTEOS_PRIO_AUTO) )
+#define CUTEOS_STATIC_BAD_PERIOD(CALLBACK, PERIOD, PRIORITY)    \
+    + ( (0 == (PERIOD)) || ((PERIOD) % (CUTEOS_CFG_STATIC_TICK) != 0) )
+typedef char cuteOS_static_check_tasks[(MAX_TASKS_NUM < TASK_NONE) ? 1 : -1];
+typedef char cuteOS_static_check_prio[(0 == (0 CUTEOS_CFG_STATIC_TASKS(CUTEOS_STATIC_BAD_PRIO))) ? 1 : -1];
+typedef char cuteOS_static_check_tick[((CUTEOS_CFG_STATIC_TICK) >= 1) && ((CUTEOS_CFG_STATIC_TICK) <= CUTEOS_MAX_TICK_TIME) ? 1 : -1];
+typedef char cuteOS_static_check_periods[(0 == (0 CUTEOS_CFG_STATIC_TASKS(CUTEOS_STATIC_BAD_PERIOD))) ? 1 : -1];
+#endif
+
+/**********************************************************************
+ * @brief   Hierarchical timing wheel.
+ * @details The wheel has \ref WHEEL_LEVELS levels of \ref WHEEL_SLOTS
+ *          slots, each slot holds the index of the first task of a doubly
+ *          linked list. A task due in 'delta' ticks is linked in:
+ *          - level 0, slot (expiry % 16) if delta < 16,
+ *          - level k, slot ((expiry >> 4k) % 16) if delta < 16^(k + 1).
+ *          Every tick, the tasks of the level 0 slot of the current tick
+ *          are released. Every 16^k ticks, one slot of level k is
+ *          cascaded: its tasks are linked again in the lower levels.
+ *          So, the work per tick depends on the number of tasks that
+ *          expire, not on the number of tasks, and 8 levels cover the
+ *          whole 32-bit tick count.
+ *********************************************************************/
+#define WHEEL_BITS      4
+#define WHEEL_SLOTS     (1 << WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS    8
+
+static u8_t HAL_XDATA cuteOS_wheel[WHEEL_LEVELS * WHEEL_SLOTS];
+
+/*!< Bit masks of the bits 0 to 7, to avoid shifting by a variable on the 8051. */
+static const u8_t HAL_CODE cuteOS_bit_mask[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+#define READY_BYTES     ((MAX_TASKS_NUM + 7) / 8)
+
+/**********************************************************************
+ * @brief   Ready tasks bitmap, bit (i % 8) of byte (i / 8) is set when
+ *          tasks[i] is due, i.e. linked in the ready list of its priority.
+ * @details Set by \ref cuteOS_ISR() and cleared by \ref cuteOS_Dispatch(),
+ *          so it is made of 8-bit bytes to be updated atomically.
+ *********************************************************************/
+static volatile u8_t cuteOS_ready_tasks[READY_BYTES] = {0};
+
+/**********************************************************************
+ * @brief   Ready priorities bitmap, bit p is set when at least one task
+ *          of priority p is ready.
+ * @details The ready tasks of each priority are kept in a FIFO list, from
+ *          \ref cuteOS_ready_head to \ref cuteOS_ready_tail, linked by the
+ *          task member \c ready_next.
+ *********************************************************************/
+static volatile u8_t cuteOS_ready_prio = 0;
+
+static u8_t cuteOS_ready_head[CUTEOS_PRIO_LEVELS] = {TASK_NONE, TASK_NONE, TASK_NONE, TASK_NONE,
+                                                     TASK_NONE, TASK_NONE, TASK_NONE, TASK_NONE};
+static u8_t cuteOS_ready_tail[CUTEOS_PRIO_LEVELS] = {TASK_NONE, TASK_NONE, TASK_NONE, TASK_NONE,
+                                                     TASK_NONE, TASK_NONE, TASK_NONE, TASK_NONE};
+
+/**********************************************************************
+ * @brief   Index of the lowest set bit of a byte (0 for 0).
+ * @details Gives the highest ready priority from \ref cuteOS_ready_prio
+ *          in constant time, without scanning the bits.
+ *********************************************************************/
+static const u8_t HAL_CODE cuteOS_unmap[256] = {
+    0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    7, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
+#if CUTEOS_CFG_BALANCE
+#define BALANCE_SPAN        32          /*!< Number of offsets tried for each task */
+#define PHASE_UNPLACED      0xFFFFFFFFUL    /*!< Offset not chosen yet by cuteOS_Balance() */
+
+/*!< Number of placed tasks released together with each candidate offset. */
+static u8_t HAL_XDATA cuteOS_balance_load[BALANCE_SPAN];
+#endif
+
+/*!< Number of the shortest distinct periods that set the rate-monotonic priorities, the longer ones get CUTEOS_PRIO_LOWEST. */
+#define RM_PERIODS          CUTEOS_PRIO_LOWEST
+
+/*!< The RM_PERIODS shortest distinct periods of the tasks, sorted, see cuteOS_UpdatePriorities(). */
+static u32_t HAL_XDATA cuteOS_rm_periods[RM_PERIODS];
+
+/*!< Number of task releases found still pending from a previous tick. */
+static volatile u16_t cuteOS_overruns = 0;
+
+#if CUTEOS_CFG_ISR_STATS
+/*!< Execution time of the Timer 2 ISR. */
+static cuteOS_ISR_STATS_t cuteOS_isr_stats = {0, 0, 0};
+#endif
+
+#if CUTEOS_CFG_TASK_STATS
+/*!< Number of tick times the tasks ran back to back, see \ref cuteOS_GetOverloads(). */
+static u16_t cuteOS_overloads = 0;
+#endif
+
+#if CUTEOS_CFG_LOAD_STATS
+/*!< Length of a CPU load window in Timer 2 increments. */
+#define LOAD_WINDOW_INC     ( (u32_t)CUTEOS_CFG_LOAD_WINDOW_MS * HAL_TIMER_INC_PER_MS )
+
+#if (CUTEOS_CFG_LOAD_WINDOW_MS < 1) || (CUTEOS_CFG_LOAD_WINDOW_MS > 4000)
+#error "CUTEOS_CFG_LOAD_WINDOW_MS must be 1 to 4000"
+#endif
+
+/*!< CPU load, see \ref cuteOS_GetLoadStats(). */
+static cuteOS_LOAD_STATS_t cuteOS_load_stats = {0, 0, 0, 0, 0};
+
+static u32_t cuteOS_load_start = 0;     /*!< Timestamp of the start of the running window */
+static u32_t cuteOS_load_idle = 0;      /*!< Idle increments in the running window */
+#endif
+
+#if CUTEOS_CFG_ADMISSION && CUTEOS_CFG_STATIC
+#error "CUTEOS_CFG_ADMISSION needs the dynamic task set, check a static task set with analyzer.mk"
+#endif
+
+#if CUTEOS_CFG_TRACE
+#if (CUTEOS_CFG_TRACE_SIZE < 2) || (CUTEOS_CFG_TRACE_SIZE > 256) || ((CUTEOS_CFG_TRACE_SIZE & (CUTEOS_CFG_TRACE_SIZE - 1)) != 0)
+#error "CUTEOS_CFG_TRACE_SIZE must be a power of two from 2 to 256"
+#endif
+
+#define TRACE_MASK      ( (u8_t)(CUTEOS_CFG_TRACE_SIZE - 1) )
+#define TRACE_VERSION   1
+
+/*!< A trace event, see \ref CUTEOS_TRACE_TICK. */
+typedef struct {
+    u8_t type;
+    u8_t arg;
+    u16_t stamp;        /*!< Time in Timer 2 increments, low 16 bits */
+} cuteOS_TRACE_EVENT_t;
+
+/*!< The trace ring: the oldest events are overwritten. */
+static cuteOS_TRACE_EVENT_t HAL_XDATA cuteOS_trace[CUTEOS_CFG_TRACE_SIZE];
+
+static u8_t cuteOS_trace_head = 0;          /*!< Next event to write */
+static u16_t cuteOS_trace_count = 0;        /*!< Events written since the last dump, saturates at 0xFFFF */
+static BOOL_t cuteOS_trace_on = TRUE;       /*!< See \ref cuteOS_TraceEnable() */
+
+/**********************************************************************
+ * @brief   Record a trace event.
+ * @details A macro, not a function: expanded in place in the ISR and in
+ *          the tasks, it has no locals of its own, so there is nothing for
+ *          the linker to overlay or to exclude (see \ref cuteOS_ISR()).
+ *          From a task, call it with the interrupts disabled, as the ISR
+ *          writes the same ring (see \ref TRACE_TASK()).
+ *          Without \ref CUTEOS_CFG_TRACE, it expands to nothing: the
+ *          arguments, the time stamp included, are not even evaluated.
+ *********************************************************************/
+#define TRACE(TYPE, ARG, STAMP)                                             \
+    do {                                                                    \
+        if(cuteOS_trace_on) {                                               \
+            cuteOS_trace[cuteOS_trace_head].type = (TYPE);                  \
+            cuteOS_trace[cuteOS_trace_head].arg = (u8_t)(ARG);              \
+            cuteOS_trace[cuteOS_trace_head].stamp = (u16_t)(STAMP);         \
+            cuteOS_trace_head = (u8_t)(cuteOS_trace_head + 1) & TRACE_MASK; \
+            if(cuteOS_trace_count != 0xFFFF) {                              \
+                ++cuteOS_trace_count;                                       \
+            }                                                               \
+        }                                                                   \
+    } while(0)
+
+/*!< Record a trace event from a task, stamped with the current time. */
+#define TRACE_TASK(TYPE, ARG)                                               \
+    do {                                                                    \
+        HAL_INT_DISABLE();                                                  \
+        TRACE((TYPE), (ARG), cuteOS_Timestamp());                           \
+        HAL_INT_ENABLE();                                                   \
+    } while(0)
+
+/*!< Time of the current tick in Timer 2 increments, low 16 bits (the product wraps around consistently). */
+#define TRACE_TICK_STAMP()  ( (u16_t)cuteOS_tick_count * cuteOS_tick_increments )
+#else
+#define TRACE(TYPE, ARG, STAMP)
+#define TRACE_TASK(TYPE, ARG)
+#endif
+
+/*!< Nesting level of \ref cuteOS_CriticalEnter(). */
+static u8_t cuteOS_critical_nesting = 0;
+
+#if CUTEOS_CFG_HYBRID
+/*!< The preemptive task, run from the Timer 2 ISR. */
+static ERROR_t (* volatile cuteOS_hp_callback)(void) = NULL;
+static u32_t cuteOS_hp_period = 0;   /*!< Period of the preemptive task in time units */
+static u16_t cuteOS_hp_ticks = 0;      /*!< Period of the preemptive task in ticks */
+static u16_t cuteOS_hp_remaining = 0;  /*!< Ticks left until the next run of the preemptive task */
+#endif
+
+/*!< Number of Timer 2 increments in one tick. */
+static u16_t cuteOS_tick_increments = 0;
+
+#if CUTEOS_CFG_TIMERS
+#define TIMER_ARMED     0x01    /*!< The timer is linked in the expiry list */
+#define TIMER_FIRED     0x02    /*!< The timer is linked in the fired list, its callback is due */
+#define TIMER_RELOAD    0x04    /*!< The auto-reload timer expired, it is linked again after its callback */
+
+/*!< Software timer information structure. */
+typedef struct {
+    ERROR_t (*callback)(void);  /*!< Pointer to the timer function, NULL for a free timer */
+    u32_t duration;     /*!< Duration in time units */
+    u32_t ticks;        /*!< Duration in ticks */
+    u32_t expiry;       /*!< Tick count of the expiry */
+    u8_t  next;         /*!< Next timer in the expiry list */
+    u8_t  fired_next;   /*!< Next timer in the fired list */
+    u8_t  mode;         /*!< \ref CUTEOS_TIMER_ONE_SHOT or \ref CUTEOS_TIMER_AUTO_RELOAD */
+    u8_t  state;        /*!< \ref TIMER_ARMED, \ref TIMER_FIRED and \ref TIMER_RELOAD flags */
+}cuteOS_TIMER_t;
+
+static cuteOS_TIMER_t HAL_XDATA cuteOS_timers[CUTEOS_CFG_TIMERS];
+
+/**********************************************************************
+ * @brief   First armed timer, the list is sorted by expiry.
+ * @details The expiries are all after the current tick, so they are
+ *          sorted by (expiry - tick count), which does not wrap around.
+ *          The ISR only compares the tick count with the expiry of the
+ *          first timer.
+ *********************************************************************/
+static u8_t cuteOS_timer_head = TASK_NONE;
+
+/**********************************************************************
+ * @brief   Low byte of the expiry of the first armed timer.
+ * @details The ISR compares it with the low byte of the tick count before
+ *          the 32-bit expiry in XDATA, so most ticks cost one byte
+ *          compare. It is updated by \ref TIMER_DUE_UPDATE() whenever the
+ *          first timer or its expiry changes.
+ *********************************************************************/
+static u8_t cuteOS_timer_due = 0;
+
+/*!< Cache the low byte of the first expiry, see cuteOS_timer_due. A macro: it is expanded in the ISR too. */
+#define TIMER_DUE_UPDATE()                                                      \
+    do {                                                                        \
+        if(cuteOS_timer_head != TASK_NONE) {                                    \
+            cuteOS_timer_due = (u8_t)cuteOS_timers[cuteOS_timer_head].expiry;   \
+        }                                                                       \
+    } while(0)
+
+/*!< FIFO list of the expired timers whose callback is due, run by cuteOS_Dispatch(). */
+static volatile u8_t cuteOS_timer_fired = TASK_NONE;
+static u8_t cuteOS_timer_fired_tail = TASK_NONE;
+
+/*!< Something to run: a ready task or an expired timer */
+#define CUTEOS_PENDING()    ( (cuteOS_ready_prio != 0) || (cuteOS_timer_fired != TASK_NONE) )
+#else
+#define CUTEOS_PENDING()    ( cuteOS_ready_prio != 0 )
+#endif
+
+#if CUTEOS_CFG_EVENTS
+/*!< First task of the list of the event tasks, walked by cuteOS_EventSet(). */
+static u8_t cuteOS_event_tasks = TASK_NONE;
+
+/*!< Events that released the running task, see cuteOS_EventGet(). */
+static u8_t cuteOS_running_events = 0;
+#endif
+
+#if CUTEOS_CFG_TICKLESS
+/*!< Maximum number of ticks one Timer 2 period can cover. */
+static u8_t cuteOS_max_step = 1;
+#endif
+
+/**********************************************************************
+ * @brief   Number of ticks covered by the running Timer 2 period.
+ * @details Always 1 in periodic mode, except for the two periods after a
+ *          tick time switch (\ref cuteOS_TickSwitch()): they were loaded
+ *          with the old tick time, so each one covers several new ticks.
+ *********************************************************************/
+static u16_t cuteOS_step = 1;
+
+/*!< Number of ticks covered by the Timer 2 period loaded in the reload registers. */
+static u16_t cuteOS_step_next = 1;
+
+#if CUTEOS_CFG_POWER_DOWN
+static BOOL_t cuteOS_power_down_on = TRUE;  /*!< See \ref cuteOS_PowerDownEnable() */
+static u16_t cuteOS_power_down_rest = 0;   /*!< Time slept in power-down not counted in ticks yet, in time units */
+
+/*!< Enter power-down mode or idle mode, whichever fits */
+#define CUTEOS_SLEEP()      cuteOS_Sleep()
+#else
+#define CUTEOS_SLEEP()      HAL_Idle()
+#endif
 
 
 
@@ -82,229 +534,2537 @@ cuteOS_TASK_t tasks[MAX_TASKS_NUM] = {0};
 /*                          PUBLIC FUNCTIONS                          */
 /*--------------------------------------------------------------------*/
 /**********************************************************************
- * @details This function does the following:
- *          - Increment the task counter.
- *          - Set the task ID.
- *          - Set the pointer to the task function.
- *          - Set the number of schedular ticks after which the task will run.
+ * @details The task is set up by \ref cuteOS_TaskAlloc(). Its number of
+ *          schedular ticks, its rate-monotonic priority
+ *          (\ref CUTEOS_PRIO_AUTO) and its automatic offset
+ *          (\ref CUTEOS_OFFSET_AUTO) are set by \ref cuteOS_UpdateTicks().
+ *          After \ref cuteOS_Start(), the tick time is fitted to the
+ *          period and the offset by \ref cuteOS_TickFit(), then the task
+ *          alone is scheduled by \ref cuteOS_TaskSchedule(): the other
+ *          tasks are not touched unless the tick time changes.
+ * @note    Not available with the static task set (\ref CUTEOS_CFG_STATIC).
+ *********************************************************************/
+#if !CUTEOS_CFG_STATIC
+#if CUTEOS_CFG_ADMISSION
+ERROR_t cuteOS_TaskCreateOffset(ERROR_t (* const callback)(void), const u32_t PERIOD, const u8_t PRIORITY, const u32_t OFFSET, cuteOS_TASK_HANDLE_t * const ptr_handle) {
+    return cuteOS_TaskCreateBudget(callback, PERIOD, PRIORITY, OFFSET, 0, ptr_handle);
+}
+
+/**********************************************************************
+ * @details Same as \ref cuteOS_TaskCreateOffset(), with the check of
+ *          \ref cuteOS_Admit() once the task is allocated: a refused task
+ *          is removed before the tick time is fitted, so the running tasks
+ *          are not touched.
+ *********************************************************************/
+ERROR_t cuteOS_TaskCreateBudget(ERROR_t (* const callback)(void), const u32_t PERIOD, const u8_t PRIORITY, const u32_t OFFSET, const u16_t WCET_US, cuteOS_TASK_HANDLE_t * const ptr_handle) {
+#else
+ERROR_t cuteOS_TaskCreateOffset(ERROR_t (* const callback)(void), const u32_t PERIOD, const u8_t PRIORITY, const u32_t OFFSET, cuteOS_TASK_HANDLE_t * const ptr_handle) {
+#endif
+    ERROR_t error = ERROR_NO;
+    u8_t i = TASK_NONE;
+
+    if( (NULL == callback) || (0 == PERIOD) ||
+        ( (PRIORITY >= CUTEOS_PRIO_LEVELS) && (PRIORITY != CUTEOS_PRIO_AUTO) ) ||
+        ( (OFFSET >= PERIOD) && (OFFSET != CUTEOS_OFFSET_AUTO) ) ) {
+        error |= ERROR_ILLEGAL_PARAM;
+    } else {
+        i = cuteOS_TaskAlloc(callback, PERIOD, PRIORITY, OFFSET);
+        if(TASK_NONE == i) {
+            error |= ERROR_OUT_OF_RANGE;
+        } else {
+#if CUTEOS_CFG_ADMISSION
+            tasks[i].wcet_us = WCET_US;
+            error |= cuteOS_Admit(i, PERIOD);
+#endif
+            if( (ERROR_NO == error) && (TRUE == cuteOS_started) ) {
+                error |= cuteOS_TickFit(cuteOS_GCD2(PERIOD, (CUTEOS_OFFSET_AUTO == OFFSET) ? 0 : OFFSET));
+                if(ERROR_NO == error) {
+                    cuteOS_UpdatePriorities();
+                    cuteOS_TaskSchedule(i);
+                }
+            }
+            if(error != ERROR_NO) {
+                (void)cuteOS_TaskRemove(i);
+                i = TASK_NONE;
+            }
+        }
+    }
+
+    if(ptr_handle != NULL) {
+        *ptr_handle = i;
+    }
+
+    return error;
+}
+
+/**********************************************************************
+ * @details The release offset is automatic in the balancing mode
+ *          (\ref CUTEOS_CFG_BALANCE), 0 otherwise.
+ *********************************************************************/
+ERROR_t cuteOS_TaskCreate(ERROR_t (* const callback)(void), const u32_t PERIOD, const u8_t PRIORITY, cuteOS_TASK_HANDLE_t * const ptr_handle) {
+    return cuteOS_TaskCreateOffset(callback, PERIOD, PRIORITY, CUTEOS_CFG_BALANCE ? CUTEOS_OFFSET_AUTO : 0, ptr_handle);
+}
+
+#if CUTEOS_CFG_EVENTS
+/**********************************************************************
+ * @details The task is a task whose period is its timeout (0: it is not
+ *          linked in the timing wheel), linked in the list of the event
+ *          tasks. Its offset is 0: the first timeout is one timeout after
+ *          the start.
  *********************************************************************/
-ERROR_t cuteOS_TaskCreate(ERROR_t (* const callback)(void), const u16_t TICK_TIME_MS) {
+ERROR_t cuteOS_EventTaskCreate(ERROR_t (* const callback)(void), const u8_t EVENTS, const u32_t TIMEOUT, const u8_t PRIORITY, cuteOS_TASK_HANDLE_t * const ptr_handle) {
     ERROR_t error = ERROR_NO;
+    u8_t i = TASK_NONE;
+
+    if( (NULL == callback) || (0 == EVENTS) || (PRIORITY >= CUTEOS_PRIO_LEVELS) ) {
+        error |= ERROR_ILLEGAL_PARAM;
+    } else {
+        i = cuteOS_TaskAlloc(callback, TIMEOUT, PRIORITY, 0);
+        if(TASK_NONE == i) {
+            error |= ERROR_OUT_OF_RANGE;
+        } else {
+            HAL_INT_DISABLE();
+            tasks[i].event_mask = EVENTS;
+            tasks[i].event_prev = TASK_NONE;
+            tasks[i].event_next = cuteOS_event_tasks;
+            if(cuteOS_event_tasks != TASK_NONE) {
+                tasks[cuteOS_event_tasks].event_prev = i;
+            }
+            cuteOS_event_tasks = i;
+            HAL_INT_ENABLE();
 
-    if(cuteOS_task_counter < MAX_TASKS_NUM) {
-        ++cuteOS_task_counter;
-        tasks[cuteOS_task_counter - 1].id = cuteOS_task_counter - 1;
-        tasks[cuteOS_task_counter - 1].delay_ms = TICK_TIME_MS;
-        tasks[cuteOS_task_counter - 1].callback = callback;
+#if CUTEOS_CFG_ADMISSION
+            tasks[i].wcet_us = 0;
+            error |= cuteOS_Admit(i, TIMEOUT);     /*!< Not checked itself, but its timeout may reduce the tick time */
+#endif
+            if( (ERROR_NO == error) && (TRUE == cuteOS_started) ) {
+                error |= cuteOS_TickFit(TIMEOUT);
+                if(ERROR_NO == error) {
+                    cuteOS_TaskSchedule(i);
+                }
+            }
+            if(error != ERROR_NO) {
+                (void)cuteOS_TaskRemove(i);
+                i = TASK_NONE;
+            }
+        }
+    }
+
+    if(ptr_handle != NULL) {
+        *ptr_handle = i;
+    }
+
+    return error;
+}
+#endif
+
+/**********************************************************************
+ * @details This function does the following:
+ *          - Check the period against the offset of the task.
+ *          - Fit the tick time to the period (\ref cuteOS_TickFit()): Timer 2
+ *            is only reprogrammed if the tick time does not divide it.
+ *          - Update the rate-monotonic priorities.
+ *          - Schedule the task again (\ref cuteOS_TaskSchedule()).
+ *          Before \ref cuteOS_Start(), only the period is set, the ticks
+ *          are computed by \ref cuteOS_UpdateTicks().
+ *********************************************************************/
+ERROR_t cuteOS_TaskSetPeriod(const cuteOS_TASK_HANDLE_t HANDLE, const u32_t PERIOD) {
+    ERROR_t error = ERROR_NO;
+    BOOL_t periodic = TRUE;
 
-        // error |= cuteOS_UpdateTicks();
+    if( (HANDLE >= MAX_TASKS_NUM) || (NULL == tasks[HANDLE].callback) ) {
+        error |= ERROR_YES;
     } else {
-        error |= ERROR_OUT_OF_RANGE;
+#if CUTEOS_CFG_EVENTS
+        periodic = (0 == tasks[HANDLE].event_mask) ? TRUE : FALSE;
+#endif
+        if( ( (TRUE == periodic) && (0 == PERIOD) ) ||
+            ( (tasks[HANDLE].offset >= PERIOD) && (tasks[HANDLE].offset != CUTEOS_OFFSET_AUTO) && (tasks[HANDLE].offset != 0) ) ) {
+            error |= ERROR_ILLEGAL_PARAM;
+#if CUTEOS_CFG_ADMISSION
+        } else if(cuteOS_Admit(HANDLE, PERIOD) != ERROR_NO) {
+            error |= ERROR_BUSY;
+#endif
+        } else if(TRUE == cuteOS_started) {
+            error |= cuteOS_TickFit(PERIOD);
+            if(ERROR_NO == error) {
+                tasks[HANDLE].period = PERIOD;
+                cuteOS_UpdatePriorities();
+                cuteOS_TaskSchedule(HANDLE);
+            }
+        } else {
+            tasks[HANDLE].period = PERIOD;
+        }
     }
 
     return error;
 }
+#endif
 
 /**********************************************************************
  * @details This function does the following:
- *          - Search for the task in the tasks array.
- *          - If found, remove the task from the tasks array.
- *          - Rearrange the tasks array.
+ *          - Unlink the task from the timing wheel and from the list of
+ *            the event tasks, and drop its pending release.
+ *          - Put its slot in the free slots list.
  *          - Decrement the task counter.
- *          - If the task is not available, an error is returned.
- * @param[in] callback: Pointer to the task function.
- * @return  \c ERROR_t: Check the options in the global enum \ref ERROR_t.
+ *          All in constant time. The tick time and the releases of the
+ *          other tasks do not change, Timer 2 is not touched.
  *********************************************************************/
-ERROR_t cuteOS_TaskRemove(ERROR_t (* const callback)(void)) {
-    ERROR_t error = ERROR_YES;
-    u8_t i;
+ERROR_t cuteOS_TaskRemove(const cuteOS_TASK_HANDLE_t HANDLE) {
+    ERROR_t error = ERROR_NO;
+
+    if( (HANDLE >= MAX_TASKS_NUM) || (NULL == tasks[HANDLE].callback) ) {
+        error |= ERROR_YES;
+    } else {
+        HAL_INT_DISABLE();
+        cuteOS_WheelUnlink(HANDLE);
+        cuteOS_ReadyUnlink(HANDLE);
+#if CUTEOS_CFG_EVENTS
+        cuteOS_EventUnlink(HANDLE);
+#endif
+        tasks[HANDLE].callback = NULL;
+        tasks[HANDLE].suspended = FALSE;
+        TRACE(CUTEOS_TRACE_TASK_REMOVE, HANDLE, cuteOS_Timestamp());
+        HAL_INT_ENABLE();
 
-    /*!< Find the task in the task array */
-    for(i = 0; i < cuteOS_task_counter; ++i) {
-        if(tasks[i].callback == callback) {
-            error |= ERROR_NO;   /*!< Task found */
+        tasks[HANDLE].next = cuteOS_task_free;
+        cuteOS_task_free = HANDLE;
+        --cuteOS_task_counter;
+    }
 
-            /*!< Rearrange the tasks array */
-            for(; i < cuteOS_task_counter - 1; ++i) {
-                tasks[i] = tasks[i + 1];
-            }
+    return error;
+}
 
-            --cuteOS_task_counter;
-            tasks[cuteOS_task_counter].callback = NULL;            
+/**********************************************************************
+ * @details The task is unlinked from the timing wheel and its pending
+ *          release is dropped. Its next release tick is kept, so
+ *          \ref cuteOS_TaskResume() can keep its phase.
+ *********************************************************************/
+ERROR_t cuteOS_TaskSuspend(const cuteOS_TASK_HANDLE_t HANDLE) {
+    ERROR_t error = ERROR_NO;
 
-            error |= cuteOS_UpdateTicks();
+    if( (HANDLE >= MAX_TASKS_NUM) || (NULL == tasks[HANDLE].callback) ) {
+        error |= ERROR_YES;
+    } else {
+        HAL_INT_DISABLE();
+        cuteOS_WheelUnlink(HANDLE);
+        cuteOS_ReadyUnlink(HANDLE);
+        tasks[HANDLE].suspended = TRUE;
+        HAL_INT_ENABLE();
+    }
 
-            break;
+    return error;
+}
+
+/**********************************************************************
+ * @details The task is linked again in the timing wheel at its first
+ *          release after the current tick, on the grid of its previous
+ *          releases: its next release tick is moved by whole periods.
+ *          An event task waits for its timeout from the current tick.
+ *          A task suspended before \ref cuteOS_Start() is linked by it.
+ *********************************************************************/
+ERROR_t cuteOS_TaskResume(const cuteOS_TASK_HANDLE_t HANDLE) {
+    ERROR_t error = ERROR_NO;
+    u32_t late;
+
+    if( (HANDLE >= MAX_TASKS_NUM) || (NULL == tasks[HANDLE].callback) ) {
+        error |= ERROR_YES;
+    } else if(TRUE == tasks[HANDLE].suspended) {
+        HAL_INT_DISABLE();
+        tasks[HANDLE].suspended = FALSE;
+        if(tasks[HANDLE].ticks != 0) {      /*!< Else: not started yet, or an event task without timeout */
+#if CUTEOS_CFG_EVENTS
+            if(tasks[HANDLE].event_mask != 0) {
+                tasks[HANDLE].expiry = cuteOS_tick_count + tasks[HANDLE].ticks;
+            } else
+#endif
+            {
+                late = cuteOS_tick_count - tasks[HANDLE].expiry;
+                if((s32_t)late >= 0) {
+                    tasks[HANDLE].expiry += ((late / tasks[HANDLE].ticks) + 1) * tasks[HANDLE].ticks;
+                }
+            }
+            cuteOS_WheelInsert(HANDLE);
         }
+        HAL_INT_ENABLE();
     }
 
     return error;
 }
 
 /**********************************************************************
- * @details Go to idle mode for some time = tickTimeInMs by disabling
- *          all interrupts and setting the sleep mode to Idle.
+ * @details Run the tasks released by \ref cuteOS_ISR(), then go to idle
+ *          mode until the next tick. With \ref CUTEOS_CFG_LOAD_STATS, the
+ *          time spent in idle mode is measured at each pass. With
+ *          \ref CUTEOS_CFG_POWER_DOWN, the idle mode may be a power-down
+ *          (\ref cuteOS_Sleep()).
  * @note    The next clock tick will return the processor to the normal operating state.
  *********************************************************************/
 void cuteOS_Start(void) {
+#if CUTEOS_CFG_LOAD_STATS
+    u32_t idle_start;
+    u32_t now;
+#endif
+
+#if CUTEOS_CFG_STATIC
+    cuteOS_StaticLoad();
+#else
     cuteOS_UpdateTicks();
+    cuteOS_started = TRUE;
+#endif
+#if CUTEOS_CFG_LOAD_STATS
+    cuteOS_load_start = cuteOS_Timestamp();
+#endif
 	while(1) {
-        PCON |= 0x01;   /*!< Enter idle mode to save power */
+        cuteOS_Dispatch();
+
+#if CUTEOS_CFG_LOAD_STATS
+        now = cuteOS_Timestamp();
+        idle_start = now;
+        if(!CUTEOS_PENDING()) {
+            CUTEOS_SLEEP(); /*!< Enter idle (or power-down) mode to save power */
+            now = cuteOS_Timestamp();
+            if(cuteOS_load_stats.idle_entries != 0xFFFFFFFFUL) {
+                ++cuteOS_load_stats.idle_entries;
+            }
+        }
+        cuteOS_LoadUpdate(now, now - idle_start);
+#else
+        if(!CUTEOS_PENDING()) {
+            CUTEOS_SLEEP(); /*!< Enter idle (or power-down) mode to save power */
+        }
+#endif
 	}
 }
 
-ERROR_t cuteOS_GetTickTime(u8_t * const ptr_tick_time_ms){
+#if CUTEOS_CFG_POWER_DOWN
+void cuteOS_PowerDownEnable(const BOOL_t ALLOW) {
+    cuteOS_power_down_on = ALLOW;
+}
+#endif
+
+#if CUTEOS_CFG_TIMERS
+/**********************************************************************
+ * @details This function does the following:
+ *          - Find the timer of the callback, or a free timer.
+ *          - Set its duration and mode.
+ *          - Arm it (see \ref cuteOS_TimerArm()): a running timer is
+ *            unlinked first and its pending run, if any, is kept.
+ *********************************************************************/
+ERROR_t cuteOS_TimerStart(ERROR_t (* const callback)(void), const u32_t DURATION, const u8_t MODE) {
     ERROR_t error = ERROR_NO;
+    u8_t i;
 
-    if(ptr_tick_time_ms != NULL) {
-        if(0 == cuteOS_tick_time_ms) {
-            cuteOS_tick_time_ms = MAX_TICK_TIME_MS;
+    if( (NULL == callback) || (0 == DURATION) ||
+        ( (MODE != CUTEOS_TIMER_ONE_SHOT) && (MODE != CUTEOS_TIMER_AUTO_RELOAD) ) ) {
+        error |= ERROR_ILLEGAL_PARAM;
+    } else {
+        i = cuteOS_TimerFind(callback);
+        if(TASK_NONE == i) {
+            i = cuteOS_TimerFind(NULL);     /*!< Free timer */
         }
 
-        *ptr_tick_time_ms = cuteOS_tick_time_ms;
-    } else {
-        error |= ERROR_NULL_POINTER;
+        if(TASK_NONE == i) {
+            error |= ERROR_OUT_OF_RANGE;
+        } else {
+            HAL_INT_DISABLE();
+            cuteOS_TimerUnlink(i);
+            cuteOS_timers[i].callback = callback;
+            cuteOS_timers[i].duration = DURATION;
+            cuteOS_timers[i].mode = MODE;
+            HAL_INT_ENABLE();
+
+            cuteOS_TimerArm(i);
+        }
     }
 
     return error;
 }
 
 /**********************************************************************
- * @details Initialize the Cute OS using Timer 2 overflow:
- *          - Timer mode
- *          - Tick time
- *          - Interrupt enable
- *          - Auto-reload mode
+ * @details The timer is unlinked from the expiry list and from the
+ *          fired list, then its slot is freed.
  *********************************************************************/
-ERROR_t cuteOS_Init(void) {
+ERROR_t cuteOS_TimerStop(ERROR_t (* const callback)(void)) {
     ERROR_t error = ERROR_NO;
-    u16_t increments, reload_16;
-    u8_t tick_time_ms;
+    u8_t prev = TASK_NONE;
+    u8_t i;
+    u8_t j;
+
+    i = (NULL == callback) ? TASK_NONE : cuteOS_TimerFind(callback);
+    if(TASK_NONE == i) {
+        error |= ERROR_YES;
+    } else {
+        HAL_INT_DISABLE();
+        cuteOS_TimerUnlink(i);
 
-    TR2 = 0;                                 /*!< Disable Timer 2 */
+        /*!< Drop its pending run */
+        if(cuteOS_timers[i].state & TIMER_FIRED) {
+            for(j = cuteOS_timer_fired; j != i; j = cuteOS_timers[j].fired_next) {
+                prev = j;
+            }
+            if(TASK_NONE == prev) {
+                cuteOS_timer_fired = cuteOS_timers[i].fired_next;
+            } else {
+                cuteOS_timers[prev].fired_next = cuteOS_timers[i].fired_next;
+            }
+            if(cuteOS_timer_fired_tail == i) {
+                cuteOS_timer_fired_tail = prev;
+            }
+        }
 
-    /******************************************************************
-     * Enable Timer 2 (16-bit timer) and configure it as a timer and automatically 
-     * reloaded its value at overflow and 
-     ******************************************************************/
-    T2CON = 0x04;   /*!< Load Timer 2 control register  */
+        cuteOS_timers[i].state = 0;
+        cuteOS_timers[i].callback = NULL;
+        HAL_INT_ENABLE();
+    }
 
-    /*!< Number of timer increments required (max 65536)    */
-    /*!< increments = (Number of mSec) * (Number of Instructions per mSec)       */
-    /*!< Number of mSec = tick_time_ms                                */
-    /*!< Number of Instructions per mSec = (Number of Oscillations per mSec) * (Number of Instructions per Oscillation) */  
-    /*!< Number of Oscillations per mSec = OSC_FREQ(MHz) / 1000 */   
-    /*!< Number of Instructions per Oscillation = 1 / OSC_PER_INST */
-    error |= cuteOS_GetTickTime(&tick_time_ms);
-    increments = (u16_t) ( ((u32_t)tick_time_ms * (OSC_FREQ/1000)) / (u32_t)OSC_PER_INST );
+    return error;
+}
+
+ERROR_t cuteOS_TimerRestart(ERROR_t (* const callback)(void)) {
+    ERROR_t error = ERROR_NO;
+    u8_t i;
 
-    reload_16 = (u16_t)(65536UL - increments);
-    RCAP2H = TH2 = (u8_t)(reload_16 / 256);   /*!< Load T2 and reload capt. reg. high bytes   */
-    RCAP2L = TL2 = (u8_t)(reload_16 % 256);   /*!< Load T2 and reload capt. reg. low bytes    */
+    i = (NULL == callback) ? TASK_NONE : cuteOS_TimerFind(callback);
+    if(TASK_NONE == i) {
+        error |= ERROR_YES;
+    } else {
+        HAL_INT_DISABLE();
+        cuteOS_TimerUnlink(i);
+        HAL_INT_ENABLE();
 
-    ET2 = 1;                                /*!< Enable Timer 2 interrupt    */
-    TR2 = 1;                                /*!< Start Timer 2    */
-    EA = 1;                                 /*!< Globally enable interrupts   */
+        cuteOS_TimerArm(i);
+    }
 
     return error;
 }
 
+ERROR_t cuteOS_TimerRemaining(ERROR_t (* const callback)(void), u32_t * const ptr_remaining) {
+    ERROR_t error = ERROR_NO;
+    u32_t ticks = 0;
+    u16_t tick_time;
+    u8_t i;
+
+    i = (NULL == callback) ? TASK_NONE : cuteOS_TimerFind(callback);
+    if(NULL == ptr_remaining) {
+        error |= ERROR_NULL_POINTER;
+    } else if(TASK_NONE == i) {
+        error |= ERROR_YES;
+    } else {
+        HAL_INT_DISABLE();
+        if(cuteOS_timers[i].state & (TIMER_ARMED | TIMER_RELOAD)) {
+            ticks = cuteOS_timers[i].expiry - cuteOS_tick_count;
+            if(ticks >= 0x80000000UL) {
+                ticks = 0;      /*!< Waiting for its reload, already late */
+            }
+        }
+        HAL_INT_ENABLE();
 
+        error |= cuteOS_GetTickTime(&tick_time);
+        *ptr_remaining = ticks * tick_time;
+    }
 
+    return error;
+}
+#endif
 
-/*--------------------------------------------------------------------*/
-/*  PRIVATE FUNCTIONS DEFINITIONS                                     */
-/*--------------------------------------------------------------------*/
+#if CUTEOS_CFG_EVENTS
 /**********************************************************************
- * @brief   cuteOS_ISR() is invoked periodically by Timer 2 overflow
- * @note    See cuteOS_Init() for timing details.
+ * @details This function does the following for each event task waiting
+ *          on one of the events:
+ *          - Add the events to the events of the task.
+ *          - Append the task to the ready list of its priority, unless it
+ *            is already ready.
+ *          - Link the task again in the timing wheel, one timeout after
+ *            the current tick.
+ *
+ *          The interrupt enable is saved and restored, not set: from an
+ *          ISR the interrupts stay disabled until its return, and a task
+ *          calling it in a critical section stays in it.
  *********************************************************************/
-static void cuteOS_ISR() interrupt INTERRUPT_Timer_2_Overflow {
+void cuteOS_EventSet(const u8_t EVENTS) HAL_REENTRANT {
+    u8_t ea;
     u8_t i;
 
-    /*!< Must manually reset the timer 2 interrupt flag    */
-    TF2 = 0;       
+    HAL_INT_SAVE(ea);
+    for(i = cuteOS_event_tasks; i != TASK_NONE; i = tasks[i].event_next) {
+        if( (tasks[i].event_mask & EVENTS) && (FALSE == tasks[i].suspended) ) {
+            tasks[i].events |= tasks[i].event_mask & EVENTS;
 
-    /*!< Increment the tick time counter */
-    ++cuteOS_tick_count;
+            if(0 == (cuteOS_ready_tasks[i >> 3] & cuteOS_bit_mask[i & 0x07])) {
+                cuteOS_ReadyAppend(i);
+            }
 
-    /*!< Check if the tick time counter has reached the required tick time */
-    for(i = 0; i < cuteOS_task_counter; ++i) {
-        if( (cuteOS_tick_count % tasks[i].ticks) == 0) {
-            if(tasks[i].callback != NULL) {
-                tasks[i].callback();
+            /*!< Restart the timeout */
+            if(tasks[i].slot != TASK_NONE) {
+                cuteOS_WheelUnlink(i);
+                tasks[i].expiry = cuteOS_tick_count + tasks[i].ticks;
+                cuteOS_WheelInsert(i);
             }
         }
     }
-        
-    /*!< Reset the tick time counter */
-    // cuteOS_tick_count = 0;
+    HAL_INT_RESTORE(ea);
 }
 
-static ERROR_t cuteOS_UpdateTicks(void) {
+ERROR_t cuteOS_EventGet(u8_t * const ptr_events) {
     ERROR_t error = ERROR_NO;
-    u32_t gcd_delay_ms;
-    u8_t i;
 
-    /*!< Find the maximum tick time among all the tasks */
-    error |= cuteOS_GCD(&gcd_delay_ms);
+    if(ptr_events != NULL) {
+        *ptr_events = cuteOS_running_events;
+    } else {
+        error |= ERROR_NULL_POINTER;
+    }
+
+    return error;
+}
+#endif
 
-    error |= cuteOS_SetTickTime(gcd_delay_ms);
+#if CUTEOS_CFG_HYBRID
+/**********************************************************************
+ * @details The period is added to the GCD of the periods, so the tick
+ *          time is updated. The period in ticks must fit in 16 bits.
+ *          After \ref cuteOS_Start(), the tick time is only fitted to the
+ *          period (\ref cuteOS_TickFit()). The countdown also covers the
+ *          Timer 2 periods already loaded, so the ISR cannot step over 0.
+ *********************************************************************/
+ERROR_t cuteOS_PreemptiveTaskCreate(ERROR_t (* const callback)(void), const u32_t PERIOD) {
+    ERROR_t error = ERROR_NO;
+    u32_t ticks;
 
-    /*!< Update the number of ticks for each task */
-    for(i = 0; i < cuteOS_task_counter; ++i) {
-        tasks[i].ticks = tasks[i].delay_ms / gcd_delay_ms;
+    if( (NULL == callback) || (0 == PERIOD) ) {
+        error |= ERROR_ILLEGAL_PARAM;
+    } else if(cuteOS_hp_callback != NULL) {
+        error |= ERROR_BUSY;
+    } else if(TRUE == cuteOS_started) {
+        error |= cuteOS_TickFit(PERIOD);
+        ticks = PERIOD / cuteOS_tick_time;
+        if( (ERROR_NO == error) && ((ticks + (2 * WHEEL_SLOTS)) > 0xFFFF) ) {
+            error |= ERROR_OUT_OF_RANGE;
+        }
+        if(ERROR_NO == error) {
+            HAL_INT_DISABLE();
+            cuteOS_hp_period = PERIOD;
+            cuteOS_hp_ticks = (u16_t)ticks;
+            cuteOS_hp_remaining = (u16_t)(ticks + cuteOS_step + cuteOS_step_next);
+            cuteOS_hp_callback = callback;
+            HAL_INT_ENABLE();
+        }
+    } else {
+        cuteOS_hp_period = PERIOD;
+        cuteOS_hp_callback = callback;
+        error |= cuteOS_UpdateTicks();
     }
 
     return error;
 }
 
-static ERROR_t cuteOS_GCD(u32_t *gcd) {
+/**********************************************************************
+ * @details After \ref cuteOS_Start(), the tick time is kept.
+ *********************************************************************/
+ERROR_t cuteOS_PreemptiveTaskRemove(void) {
     ERROR_t error = ERROR_NO;
-    u32_t remainder;
-    u32_t y;
-    u8_t i;
 
-    *gcd = tasks[0].delay_ms;
-    for(i = 1; i < cuteOS_task_counter; ++i) {
-        y = tasks[i].delay_ms;
-        while(y != 0) {
-            remainder = *gcd % y;
-            *gcd = y;
-            y = remainder;
-        }
+    if(NULL == cuteOS_hp_callback) {
+        error |= ERROR_YES;
+    } else if(TRUE == cuteOS_started) {
+        HAL_INT_DISABLE();
+        cuteOS_hp_callback = NULL;
+        cuteOS_hp_ticks = 0xFFFF;   /*!< Keep its countdown far from zero */
+        cuteOS_hp_remaining = 0xFFFF;
+        HAL_INT_ENABLE();
+    } else {
+        cuteOS_hp_callback = NULL;
+        error |= cuteOS_UpdateTicks();
     }
 
-    /*!< Check if the tick time is greater than the maximum tick time */
-    i = 2;
-    while(*gcd > MAX_TICK_TIME_MS) {
-        while( (*gcd % i) != 0) {
-            ++i;
+    return error;
+}
+#endif
+
+void cuteOS_CriticalEnter(void) {
+    HAL_TIMER_INT_DISABLE();
+    ++cuteOS_critical_nesting;
+}
+
+void cuteOS_CriticalExit(void) {
+    if(cuteOS_critical_nesting > 0) {
+        if(0 == --cuteOS_critical_nesting) {
+            HAL_TIMER_INT_ENABLE();
         }
-        *gcd /= i;
+    }
+}
+
+ERROR_t cuteOS_GetOverruns(u16_t * const ptr_overruns) {
+    ERROR_t error = ERROR_NO;
+
+    if(ptr_overruns != NULL) {
+        HAL_INT_DISABLE();
+        *ptr_overruns = cuteOS_overruns;
+        HAL_INT_ENABLE();
+    } else {
+        error |= ERROR_NULL_POINTER;
     }
 
     return error;
 }
 
-/**********************************************************************
- * @details Set the value of the tick time in milliseconds. So, the
- *          timing of the tasks is determined by the frequency of Timer 2
- *          overflow. Overflow occurs every tickTimeInMs milliseconds.
- *********************************************************************/
-static ERROR_t cuteOS_SetTickTime(const u8_t TICK_TIME_MS){
+#if CUTEOS_CFG_ISR_STATS
+ERROR_t cuteOS_GetIsrStats(cuteOS_ISR_STATS_t * const ptr_stats) {
     ERROR_t error = ERROR_NO;
-    
-    if(TICK_TIME_MS <= MAX_TICK_TIME_MS) {
-		if(TICK_TIME_MS <= 1) {
-			cuteOS_tick_time_ms = 1;
-		} else {
-			cuteOS_tick_time_ms = TICK_TIME_MS;
-		}
-        error |= cuteOS_Init();
+
+    if(ptr_stats != NULL) {
+        HAL_INT_DISABLE();
+        *ptr_stats = cuteOS_isr_stats;
+        HAL_INT_ENABLE();
     } else {
-        error |= ERROR_OUT_OF_RANGE;
+        error |= ERROR_NULL_POINTER;
     }
 
     return error;
 }
+#endif
+
+#if CUTEOS_CFG_TASK_STATS
+ERROR_t cuteOS_GetTaskStats(const cuteOS_TASK_HANDLE_t HANDLE, cuteOS_TASK_STATS_t * const ptr_stats) {
+    ERROR_t error = ERROR_NO;
+
+    if(NULL == ptr_stats) {
+        error |= ERROR_NULL_POINTER;
+    } else if( (HANDLE >= MAX_TASKS_NUM) || (NULL == tasks[HANDLE].callback) ) {
+        error |= ERROR_YES;
+    } else {
+        /*!< The statistics are written by cuteOS_Dispatch() only, no need to disable the interrupts */
+        *ptr_stats = tasks[HANDLE].stats;
+    }
+
+    return error;
+}
+
+ERROR_t cuteOS_GetOverloads(u16_t * const ptr_overloads) {
+    ERROR_t error = ERROR_NO;
+
+    if(ptr_overloads != NULL) {
+        *ptr_overloads = cuteOS_overloads;
+    } else {
+        error |= ERROR_NULL_POINTER;
+    }
+
+    return error;
+}
+#endif
+
+#if CUTEOS_CFG_LOAD_STATS
+ERROR_t cuteOS_GetLoadStats(cuteOS_LOAD_STATS_t * const ptr_stats) {
+    ERROR_t error = ERROR_NO;
+
+    if(ptr_stats != NULL) {
+        /*!< The statistics are written by cuteOS_Start() only, no need to disable the interrupts */
+        *ptr_stats = cuteOS_load_stats;
+    } else {
+        error |= ERROR_NULL_POINTER;
+    }
+
+    return error;
+}
+#endif
+
+#if CUTEOS_CFG_TRACE
+/**********************************************************************
+ * @details Restarting a stopped trace empties it: the events of a dump
+ *          are then never separated by more than one Timer 2 period, so
+ *          the host can unwrap their 16-bit time.
+ *********************************************************************/
+void cuteOS_TraceEnable(const BOOL_t ENABLE) {
+    HAL_INT_DISABLE();
+    if( (TRUE == ENABLE) && (FALSE == cuteOS_trace_on) ) {
+        cuteOS_trace_count = 0;
+    }
+    cuteOS_trace_on = ENABLE;
+    HAL_INT_ENABLE();
+}
+
+ERROR_t cuteOS_TraceDump(void (* const put_byte)(const u8_t BYTE)) {
+    ERROR_t error = ERROR_NO;
+    BOOL_t was_on;
+    u16_t count;
+    u16_t lost;
+    u8_t i;
+    cuteOS_TRACE_EVENT_t HAL_XDATA * event;
+
+    if(NULL == put_byte) {
+        error |= ERROR_NULL_POINTER;
+    } else {
+        HAL_INT_DISABLE();
+        was_on = cuteOS_trace_on;
+        cuteOS_trace_on = FALSE;
+        HAL_INT_ENABLE();
+
+        count = cuteOS_trace_count;
+        lost = 0;
+        if(count > CUTEOS_CFG_TRACE_SIZE) {
+            lost = count - CUTEOS_CFG_TRACE_SIZE;
+            count = CUTEOS_CFG_TRACE_SIZE;
+        }
+
+        put_byte('c');
+        put_byte('T');
+        put_byte('R');
+        put_byte(TRACE_VERSION);
+        put_byte((u8_t)HAL_TIMER_INC_PER_MS);
+        put_byte((u8_t)(HAL_TIMER_INC_PER_MS >> 8));
+        put_byte((u8_t)count);
+        put_byte((u8_t)(count >> 8));
+        put_byte((u8_t)lost);
+        put_byte((u8_t)(lost >> 8));
+
+        /*!< Oldest first: the oldest event is 'count' events behind the head */
+        i = (u8_t)(cuteOS_trace_head - (u8_t)count) & TRACE_MASK;
+        for(; count != 0; --count) {
+            event = &cuteOS_trace[i];
+            put_byte(event->type);
+            put_byte(event->arg);
+            put_byte((u8_t)event->stamp);
+            put_byte((u8_t)(event->stamp >> 8));
+            i = (u8_t)(i + 1) & TRACE_MASK;
+        }
+
+        cuteOS_trace_count = 0;
+        HAL_INT_DISABLE();
+        cuteOS_trace_on = was_on;
+        HAL_INT_ENABLE();
+    }
+
+    return error;
+}
+#endif
+
+ERROR_t cuteOS_GetTicks32(u32_t * const ptr_ticks) {
+    ERROR_t error = ERROR_NO;
+
+    if(ptr_ticks != NULL) {
+        (void)cuteOS_ReadTime(ptr_ticks);
+    } else {
+        error |= ERROR_NULL_POINTER;
+    }
+
+    return error;
+}
+
+/**********************************************************************
+ * @details time = ticks * (tick time in us) + (Timer 2 increments since
+ *          the tick, converted to us). The multiplications wrap around
+ *          modulo 2^32 consistently, so the differences stay right.
+ *********************************************************************/
+ERROR_t cuteOS_GetTimeUs(u32_t * const ptr_time_us) {
+    ERROR_t error = ERROR_NO;
+    u32_t ticks;
+    u16_t increments;
+
+    if(ptr_time_us != NULL) {
+        increments = cuteOS_ReadTime(&ticks);
+#if ( (OSC_FREQ / 1000UL) / OSC_PER_INST ) == 1000
+        /*!< One increment per us (12 MHz, 12 oscillations per instruction) */
+        *ptr_time_us = (ticks * ((u32_t)cuteOS_tick_time * CUTEOS_CFG_TIME_UNIT_US)) + increments;
+#else
+        *ptr_time_us = (ticks * ((u32_t)cuteOS_tick_time * CUTEOS_CFG_TIME_UNIT_US)) + (((u32_t)increments * 1000UL) / HAL_TIMER_INC_PER_MS);
+#endif
+    } else {
+        error |= ERROR_NULL_POINTER;
+    }
+
+    return error;
+}
+
+/**********************************************************************
+ * @brief   Current time of the coroutines, in time units.
+ * @details The tick count times the tick time: \ref cuteOS_TickSwitch()
+ *          multiplies the tick count by the ratio of the tick times, so
+ *          this time goes on across a tick time change, and the sleeps
+ *          keep their durations. It wraps around after 2^32 time units.
+ *********************************************************************/
+static u32_t cuteOS_CoroNow(void) {
+    u32_t ticks;
+    u16_t tick_time;
+
+    (void)cuteOS_GetTickTime(&tick_time);
+    (void)cuteOS_ReadTime(&ticks);
+
+    return ticks * tick_time;
+}
+
+/**********************************************************************
+ * @details The sleeps are compared as 32-bit differences, so they last
+ *          less than 2^31 time units. The longer ones are clamped. The tick
+ *          count is read by \ref cuteOS_ReadTime(), without disabling the
+ *          interrupts.
+ *********************************************************************/
+u32_t cuteOS_CoroWake(const u32_t DURATION) {
+    return cuteOS_CoroNow() + ((DURATION > 0x7FFFFFFFUL) ? 0x7FFFFFFFUL : DURATION);
+}
+
+BOOL_t cuteOS_CoroAwake(const u32_t WAKE) {
+    return ((s32_t)(cuteOS_CoroNow() - WAKE) >= 0) ? TRUE : FALSE;
+}
+
+ERROR_t cuteOS_GetTickTime(u16_t * const ptr_tick_time){
+    ERROR_t error = ERROR_NO;
+
+    if(ptr_tick_time != NULL) {
+        if(0 == cuteOS_tick_time) {
+            cuteOS_tick_time = CUTEOS_MAX_TICK_TIME;
+        }
+
+        *ptr_tick_time = cuteOS_tick_time;
+    } else {
+        error |= ERROR_NULL_POINTER;
+    }
+
+    return error;
+}
+
+/**********************************************************************
+ * @details Initialize the Cute OS using Timer 2 overflow:
+ *          - Empty timing wheel
+ *          - Timer mode
+ *          - Tick time
+ *          - Interrupt enable
+ *          - Auto-reload mode
+ *********************************************************************/
+ERROR_t cuteOS_Init(void) {
+    ERROR_t error = ERROR_NO;
+    u16_t increments;
+    u16_t tick_time;
+    u8_t i;
+
+    /*!< The interrupts stay disabled until Timer 2 is started with the new tick time */
+    HAL_INT_DISABLE();
+
+    /*!< Empty the timing wheel, the tasks are linked by cuteOS_UpdateTicks() */
+    for(i = 0; i < (WHEEL_LEVELS * WHEEL_SLOTS); ++i) {
+        cuteOS_wheel[i] = TASK_NONE;
+    }
+    for(i = 0; i < MAX_TASKS_NUM; ++i) {
+        tasks[i].slot = TASK_NONE;
+    }
+
+    /*!< Number of timer increments required (max 65536)    */
+    /*!< increments = (Number of time units) * (Number of Instructions per time unit)   */
+    /*!< Number of time units = tick_time                           */
+    /*!< Number of Instructions per time unit = (Number of Oscillations per time unit) * (Number of Instructions per Oscillation) */  
+    /*!< Number of Oscillations per time unit = OSC_FREQ(MHz) * CUTEOS_CFG_TIME_UNIT_US / 1000000 */   
+    /*!< Number of Instructions per Oscillation = 1 / OSC_PER_INST */
+#if CUTEOS_CFG_STATIC
+    (void)tick_time;
+    increments = CUTEOS_STATIC_INCREMENTS;     /*!< Computed by the compiler */
+#else
+    error |= cuteOS_GetTickTime(&tick_time);
+    increments = TICK_INCREMENTS(tick_time);
+#endif
+
+    cuteOS_tick_increments = increments;
+#if CUTEOS_CFG_TICKLESS
+    cuteOS_max_step = (65536UL / increments > WHEEL_SLOTS) ? WHEEL_SLOTS : (u8_t)(65536UL / increments);
+#endif
+    cuteOS_step = 1;
+    cuteOS_step_next = 1;
+
+    HAL_TimerStart(HAL_TIMER_RELOAD(increments), cuteOS_ISR);     /*!< Enables the interrupts again (EA = 1) */
+
+    return error;
+}
+
+
+
+
+/*--------------------------------------------------------------------*/
+/*  PRIVATE FUNCTIONS DEFINITIONS                                     */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @brief   cuteOS_ISR() is invoked periodically by Timer 2 overflow
+ * @details The ISR only does the bookkeeping: it increments the tick count
+ *          and marks the due tasks as ready. The tasks are executed later
+ *          by \ref cuteOS_Dispatch(), outside the interrupt, so the
+ *          interrupt latency does not depend on the tasks execution time.
+ *
+ *          The due tasks are found in the timing wheel (\ref cuteOS_wheel),
+ *          so a tick without any expiring task nor cascade costs a 32-bit
+ *          increment and one slot check, whatever the number of tasks.
+ *
+ *          In tickless mode (\ref CUTEOS_CFG_TICKLESS), one Timer 2 period
+ *          may cover several ticks: the ISR advances the wheel by the ticks
+ *          of the period that just ended, then loads the reload registers
+ *          so that the period after the running one ends at the nearest
+ *          task release (up to \c cuteOS_max_step ticks, longer intervals
+ *          are chained over several overflows).
+ *          The reload registers are written right after the overflow, so
+ *          they are never changed while the hardware can reload them.
+ *
+ *          After a tick time switch (\ref cuteOS_TickSwitch()), the two
+ *          Timer 2 periods loaded with the old tick time cover several new
+ *          ticks each, like in tickless mode: the ISR loads the new tick
+ *          time after the first one, so the switch needs no timer restart.
+ *
+ *          In hybrid mode (\ref CUTEOS_CFG_HYBRID), the ISR runs on the
+ *          register bank \ref CUTEOS_CFG_ISR_BANK and runs the preemptive
+ *          task first, so its jitter is the interrupt latency only. With a
+ *          time unit below 1 ms (\ref CUTEOS_CFG_TIME_UNIT_US), it also
+ *          runs on that bank: the ticks may be a few hundred cycles long,
+ *          and the bank switch saves pushing and popping R0 to R7.
+ *
+ *          The functions shared by the ISR and the tasks are called from
+ *          the tasks with the interrupts disabled, so they never run twice
+ *          at once. Keil BL51 still reports them as multiple calls (L15)
+ *          and may overlay their locals with those of the interrupted
+ *          task: cuteOS.uvproj excludes them from the data overlay
+ *          (OVERLAY(... ! *)): cuteOS_WheelInsert(), cuteOS_WheelUnlink(),
+ *          cuteOS_ReadyAppend() and cuteOS_TimerExpire(). Keep that list
+ *          in step when the ISR calls another function.
+ * @note    See cuteOS_Init() for timing details.
+ *********************************************************************/
+#if CUTEOS_ISR_BANKED
+HAL_TIMER_ISR_USING(cuteOS_ISR, CUTEOS_CFG_ISR_BANK) {
+#else
+HAL_TIMER_ISR(cuteOS_ISR) {
+#endif
+    u8_t slot;
+    u16_t step;
+#if CUTEOS_CFG_ISR_STATS
+    u16_t isr_entry;
+    u16_t isr_cycles;
+
+    /*!< Sample Timer 2 first: count since the overflow = count - reload of the period that just started */
+    isr_entry = HAL_TimerRead();
+    isr_cycles = isr_entry - HAL_TIMER_RELOAD((u32_t)cuteOS_step_next * cuteOS_tick_increments);
+    if(isr_cycles > cuteOS_isr_stats.entry_cycles_max) {
+        cuteOS_isr_stats.entry_cycles_max = isr_cycles;
+    }
+#endif
+
+    /*!< Must manually reset the timer 2 interrupt flag    */
+    HAL_TIMER_ISR_ACK();
+
+#if CUTEOS_CFG_HYBRID
+    /*!< Run the preemptive task before any bookkeeping */
+    cuteOS_hp_remaining -= cuteOS_step;
+    if(0 == cuteOS_hp_remaining) {
+        cuteOS_hp_remaining = cuteOS_hp_ticks;
+        if(cuteOS_hp_callback != NULL) {
+            cuteOS_hp_callback();
+        }
+    }
+#endif
+
+    /*!< The period that ended covered 'step' ticks, the one that started covers 'cuteOS_step_next' */
+    step = cuteOS_step;
+    cuteOS_step = cuteOS_step_next;
+    TRACE(CUTEOS_TRACE_TICK, step, ((u16_t)cuteOS_tick_count + step) * cuteOS_tick_increments);
+
+    do {
+        /*!< Increment the tick time counter */
+        slot = (u8_t)(++cuteOS_tick_count) & WHEEL_MASK;
+
+        /*!< Release the expiring tasks, or cascade the upper levels every 16 ticks */
+        if( (0 == slot) || (cuteOS_wheel[slot] != TASK_NONE) ) {
+            cuteOS_WheelExpire();
+        }
+
+#if CUTEOS_CFG_TIMERS
+        /*!< Only the first armed timer can expire now: compare the cached low byte first */
+        if( ((u8_t)cuteOS_tick_count == cuteOS_timer_due) && (cuteOS_timer_head != TASK_NONE) &&
+            (cuteOS_timers[cuteOS_timer_head].expiry == cuteOS_tick_count) ) {
+            cuteOS_TimerExpire();
+        }
+#endif
+    } while(--step != 0);
+
+#if CUTEOS_CFG_TICKLESS
+    /*!< Let the period after the running one end at the nearest release */
+    step = cuteOS_WheelNextStep(cuteOS_step);
+    if(step != cuteOS_step_next) {
+        cuteOS_step_next = step;
+        HAL_TimerSetReload(HAL_TIMER_RELOAD((u32_t)cuteOS_step_next * cuteOS_tick_increments));
+    }
+#else
+    /*!< The running period is the last one of the old tick time: load the new one after it */
+    if(cuteOS_step_next != 1) {
+        cuteOS_step_next = 1;
+        HAL_TimerSetReload(HAL_TIMER_RELOAD(cuteOS_tick_increments));
+    }
+#endif
+
+#if CUTEOS_CFG_ISR_STATS
+    isr_cycles = HAL_TimerRead() - isr_entry;
+    cuteOS_isr_stats.cycles_last = isr_cycles;
+    if(isr_cycles > cuteOS_isr_stats.cycles_max) {
+        cuteOS_isr_stats.cycles_max = isr_cycles;
+    }
+#endif
+}
+
+/**********************************************************************
+ * @brief   Release the tasks of the level 0 slot of the current tick.
+ * @details Called by \ref cuteOS_ISR() after incrementing the tick count,
+ *          when the slot is not empty or when the upper levels must be
+ *          cascaded (every 16 ticks). Each released task is appended to
+ *          the ready list of its priority and linked again in the wheel at
+ *          its next expiry.
+ *********************************************************************/
+static void cuteOS_WheelExpire(void) {
+    u8_t level;
+    u8_t slot;
+    u8_t index;
+    u8_t next;
+    u8_t byte;
+    u8_t mask;
+
+    /*!< Cascade level k when the lower levels wrapped around */
+    for(level = 1; level < WHEEL_LEVELS; ++level) {
+        slot = (u8_t)(cuteOS_tick_count >> (WHEEL_BITS * level)) & WHEEL_MASK;
+
+        index = cuteOS_wheel[(level * WHEEL_SLOTS) + slot];
+        cuteOS_wheel[(level * WHEEL_SLOTS) + slot] = TASK_NONE;
+        for(; index != TASK_NONE; index = next) {
+            next = tasks[index].next;
+            cuteOS_WheelInsert(index);
+        }
+
+        if(slot != 0) {
+            break;
+        }
+    }
+
+    /*!< Release the tasks expiring now */
+    slot = (u8_t)cuteOS_tick_count & WHEEL_MASK;
+    index = cuteOS_wheel[slot];
+    cuteOS_wheel[slot] = TASK_NONE;
+    for(; index != TASK_NONE; index = next) {
+        next = tasks[index].next;
+
+        byte = index >> 3;
+        mask = cuteOS_bit_mask[index & 0x07];
+        if(cuteOS_ready_tasks[byte] & mask) {
+#if CUTEOS_CFG_EVENTS
+            if(0 == tasks[index].event_mask) {     /*!< An event task released by an event is not late */
+                ++cuteOS_overruns;  /*!< Previous release did not run yet */
+                TRACE(CUTEOS_TRACE_OVERRUN, index, TRACE_TICK_STAMP());
+            }
+#else
+            ++cuteOS_overruns;      /*!< Previous release did not run yet */
+            TRACE(CUTEOS_TRACE_OVERRUN, index, TRACE_TICK_STAMP());
+#endif
+        } else {
+            cuteOS_ReadyAppend(index);
+        }
+
+        tasks[index].expiry += tasks[index].ticks;
+        cuteOS_WheelInsert(index);
+    }
+}
+
+/**********************************************************************
+ * @brief   Link a task in the timing wheel slot of its expiry.
+ * @details The level is the first one whose range covers the ticks left
+ *          until the expiry. A task expiring now (cascaded from an upper
+ *          level) goes to the level 0 slot of the current tick, which is
+ *          released right after the cascade.
+ * @note    Called with the Timer 2 interrupt disabled or from the ISR.
+ *          Shared by the ISR and the tasks, it is excluded from the Keil
+ *          data overlay (see \ref cuteOS_ISR()).
+ *********************************************************************/
+static void cuteOS_WheelInsert(const u8_t index) {
+    u32_t delta = tasks[index].expiry - cuteOS_tick_count;
+    u32_t expiry = tasks[index].expiry;
+    u8_t slot = 0;
+
+    while(delta >= WHEEL_SLOTS) {
+        delta >>= WHEEL_BITS;
+        expiry >>= WHEEL_BITS;
+        slot += WHEEL_SLOTS;
+    }
+    slot += (u8_t)expiry & WHEEL_MASK;
+
+    tasks[index].slot = slot;
+    tasks[index].prev = TASK_NONE;
+    tasks[index].next = cuteOS_wheel[slot];
+    if(cuteOS_wheel[slot] != TASK_NONE) {
+        tasks[cuteOS_wheel[slot]].prev = index;
+    }
+    cuteOS_wheel[slot] = index;
+}
+
+/**********************************************************************
+ * @brief   Unlink a task from its timing wheel slot, if it is linked.
+ * @note    Called with the Timer 2 interrupt disabled, or from an ISR
+ *          through \ref cuteOS_EventSet(): excluded from the Keil data
+ *          overlay (see \ref cuteOS_ISR()).
+ *********************************************************************/
+static void cuteOS_WheelUnlink(const u8_t index) {
+    const u8_t next = tasks[index].next;
+    const u8_t prev = tasks[index].prev;
+
+    if(tasks[index].slot != TASK_NONE) {
+        if(prev != TASK_NONE) {
+            tasks[prev].next = next;
+        } else {
+            cuteOS_wheel[tasks[index].slot] = next;
+        }
+        if(next != TASK_NONE) {
+            tasks[next].prev = prev;
+        }
+        tasks[index].slot = TASK_NONE;
+    }
+}
+
+#if CUTEOS_CFG_TICKLESS
+/**********************************************************************
+ * @brief   Number of ticks the Timer 2 period after the running one can cover.
+ * @param[in] running: Number of ticks covered by the running period.
+ * @details The running period ends at tick t = now + running. The next
+ *          period must end at the first of:
+ *          - The next release of the tasks expiring at t.
+ *          - The first non-empty level 0 slot after t.
+ *          - The next multiple of 16 ticks, where the upper levels are
+ *            cascaded. When t itself is a multiple of 16, the cascade may
+ *            bring tasks due right after t, so the next period is 1 tick.
+ *          - The next run of the preemptive task (hybrid mode).
+ *          - The next expiry of the software timers.
+ *          The steps never cross a multiple of 16 ticks, so all the tasks
+ *          due before the next cascade are in level 0. Only a period
+ *          loaded before a tick time switch (\ref cuteOS_TickSwitch()) may
+ *          cross one: the next period is 1 tick then.
+ *********************************************************************/
+static u8_t cuteOS_WheelNextStep(const u16_t running) {
+    const u16_t t = ((u8_t)cuteOS_tick_count & WHEEL_MASK) + running;
+    u8_t step = 1;
+    u8_t index;
+    u8_t u;
+#if CUTEOS_CFG_HYBRID
+    u16_t left;
+#endif
+#if CUTEOS_CFG_TIMERS
+    s32_t delta;
+#endif
+
+    if(t < WHEEL_SLOTS) {
+        step = WHEEL_SLOTS - (u8_t)t;
+
+#if CUTEOS_CFG_HYBRID
+        if(cuteOS_hp_callback != NULL) {
+            left = cuteOS_hp_remaining - running;
+            if(0 == left) {
+                left = cuteOS_hp_ticks;
+            }
+            if(left < step) {
+                step = (u8_t)left;
+            }
+        }
+#endif
+
+#if CUTEOS_CFG_TIMERS
+        /*!< The timers expiring up to t are reloaded after their callback, the first one after t ends the list walk */
+        for(index = cuteOS_timer_head; index != TASK_NONE; index = cuteOS_timers[index].next) {
+            delta = (s32_t)(cuteOS_timers[index].expiry - cuteOS_tick_count - running);
+            if(delta <= 0) {
+                if(CUTEOS_TIMER_AUTO_RELOAD == cuteOS_timers[index].mode) {
+                    delta += (s32_t)cuteOS_timers[index].ticks;
+                }
+                if( (delta > 0) && (delta < step) ) {
+                    step = (u8_t)delta;
+                }
+            } else {
+                if(delta < step) {
+                    step = (u8_t)delta;
+                }
+                break;
+            }
+        }
+
+        /*!< The expired auto-reload timers hold their next expiry until the dispatcher links them again */
+        for(index = cuteOS_timer_fired; index != TASK_NONE; index = cuteOS_timers[index].fired_next) {
+            if(cuteOS_timers[index].state & TIMER_RELOAD) {
+                delta = (s32_t)(cuteOS_timers[index].expiry - cuteOS_tick_count - running);
+                if( (delta > 0) && (delta < step) ) {
+                    step = (u8_t)delta;
+                }
+            }
+        }
+#endif
+
+        for(index = cuteOS_wheel[t]; index != TASK_NONE; index = tasks[index].next) {
+            if(tasks[index].ticks < step) {
+                step = (u8_t)tasks[index].ticks;
+            }
+        }
+
+        for(u = 1; u < step; ++u) {
+            if(cuteOS_wheel[t + u] != TASK_NONE) {
+                step = u;
+            }
+        }
+
+        if(step > cuteOS_max_step) {
+            step = cuteOS_max_step;
+        }
+    }
+
+    return step;
+}
+#endif
+
+/**********************************************************************
+ * @brief   Run the tasks made ready by \ref cuteOS_ISR(), highest priority
+ *          first, and in the order of release within the same priority.
+ *          The callbacks of the expired software timers run before them.
+ * @details The highest ready priority is found in constant time through
+ *          \ref cuteOS_unmap. The head of its ready list is taken with the
+ *          interrupts disabled for a few instructions only, then the
+ *          callback runs with the interrupts enabled. The priorities are
+ *          checked again after every task, so a task of higher priority
+ *          released meanwhile runs next.
+ *********************************************************************/
+static void cuteOS_Dispatch(void) {
+    ERROR_t (*callback)(void);
+    u8_t priority;
+    u8_t index;
+#if CUTEOS_CFG_TASK_STATS
+    u32_t busy_start;
+    u32_t start;
+    u32_t end;
+
+    if(!CUTEOS_PENDING()) {
+        return;
+    }
+
+    busy_start = cuteOS_Timestamp();
+    end = busy_start;
+#endif
+
+    while(CUTEOS_PENDING()) {
+#if CUTEOS_CFG_TIMERS
+        /*!< The expired timers run first */
+        if(cuteOS_timer_fired != TASK_NONE) {
+            cuteOS_TimerRun();
+#if CUTEOS_CFG_TASK_STATS
+            end = cuteOS_Timestamp();
+#endif
+            continue;
+        }
+#endif
+
+        HAL_INT_DISABLE();
+        priority = cuteOS_unmap[cuteOS_ready_prio];
+        index = cuteOS_ready_head[priority];
+        cuteOS_ready_head[priority] = tasks[index].ready_next;
+        if(TASK_NONE == cuteOS_ready_head[priority]) {
+            cuteOS_ready_tail[priority] = TASK_NONE;
+            cuteOS_ready_prio &= (u8_t)~cuteOS_bit_mask[priority];
+        } else {
+            tasks[cuteOS_ready_head[priority]].ready_prev = TASK_NONE;
+        }
+        cuteOS_ready_tasks[index >> 3] &= (u8_t)~cuteOS_bit_mask[index & 0x07];
+        callback = tasks[index].callback;
+#if CUTEOS_CFG_EVENTS
+        cuteOS_running_events = tasks[index].events;
+        tasks[index].events = 0;
+#endif
+        TRACE(CUTEOS_TRACE_TASK_START, index, cuteOS_Timestamp());
+        HAL_INT_ENABLE();
+#if CUTEOS_CFG_TASK_STATS
+        start = cuteOS_Timestamp();
+#endif
+
+        if(callback != NULL) {
+            callback();
+#if CUTEOS_CFG_TASK_STATS
+            end = cuteOS_Timestamp();
+            if(tasks[index].callback == callback) {     /*!< The task may have removed itself */
+                cuteOS_StatsUpdate(index, end - start);
+            }
+#endif
+        }
+        TRACE_TASK(CUTEOS_TRACE_TASK_END, index);
+    }
+
+#if CUTEOS_CFG_TASK_STATS
+    /*!< Count the tick times the tasks ran back to back */
+    end = (end - busy_start) / cuteOS_tick_increments;
+    if(end > (u32_t)(0xFFFF - cuteOS_overloads)) {
+        cuteOS_overloads = 0xFFFF;
+    } else {
+        cuteOS_overloads += (u16_t)end;
+    }
+#endif
+}
+
+#if CUTEOS_CFG_POWER_DOWN
+/**********************************************************************
+ * @brief   Enter power-down mode if nothing is due soon, idle mode otherwise.
+ * @details The decision and the power-down are taken with the interrupts
+ *          disabled, and \ref HAL_PowerDown() enables them right before
+ *          stopping the CPU: an event set by an ISR meanwhile wakes it up
+ *          at once instead of waiting for the next external interrupt.
+ *********************************************************************/
+static void cuteOS_Sleep(void) {
+    u32_t slept_ms;
+
+    HAL_INT_DISABLE();
+    if( (FALSE == cuteOS_power_down_on) || CUTEOS_PENDING() || (TRUE == cuteOS_PowerDownDue()) ) {
+        HAL_INT_ENABLE();
+        HAL_Idle();
+    } else {
+        slept_ms = HAL_PowerDown();     /*!< Enables the interrupts */
+        cuteOS_PowerResync(slept_ms);
+    }
+}
+
+/**********************************************************************
+ * @brief   Check whether some work is due within the power-down horizon.
+ * @details The work is the next release of the tasks linked in the
+ *          timing wheel (periodic tasks and event timeouts), the first
+ *          armed timer, and the preemptive task, which forbids power-down.
+ *          The tasks are scanned up to the first one due, so a busy
+ *          system stops early.
+ * @note    Called with the interrupts disabled.
+ * @return  \c BOOL_t: TRUE if some work is due within
+ *          \ref CUTEOS_CFG_POWER_DOWN_HORIZON_MS.
+ *********************************************************************/
+static BOOL_t cuteOS_PowerDownDue(void) {
+    const u32_t horizon = ((u32_t)CUTEOS_CFG_POWER_DOWN_HORIZON_MS * UNITS_PER_MS) / cuteOS_tick_time;
+    BOOL_t due = FALSE;
+    u8_t i;
+
+#if CUTEOS_CFG_HYBRID
+    if(cuteOS_hp_callback != NULL) {
+        due = TRUE;
+    }
+#endif
+#if CUTEOS_CFG_TIMERS
+    if( (cuteOS_timer_head != TASK_NONE) && ((cuteOS_timers[cuteOS_timer_head].expiry - cuteOS_tick_count) <= horizon) ) {
+        due = TRUE;
+    }
+#endif
+    for(i = 0; (i < cuteOS_task_top) && (FALSE == due); ++i) {
+        if( (tasks[i].slot != TASK_NONE) && ((tasks[i].expiry - cuteOS_tick_count) <= horizon) ) {
+            due = TRUE;
+        }
+    }
+
+    return due;
+}
+
+/**********************************************************************
+ * @brief   Resynchronize the scheduler after a power-down.
+ * @details The time slept (plus the part of a tick left from the previous
+ *          power-downs) is added to the tick count in whole ticks, then:
+ *          - Each task due meanwhile is released once, and its next
+ *            expiry is the first one of its time grid after now, so its
+ *            phase is kept. The releases skipped in power-down are not
+ *            overruns.
+ *          - The timing wheel is rebuilt, like by \ref cuteOS_TickSwitch():
+ *            the cascades of the ticks slept were skipped.
+ *          - The timers due meanwhile expire now, the auto-reload ones
+ *            restart from now.
+ *          - In tickless mode, the running Timer 2 period may cover ticks
+ *            due soon after the wake-up: Timer 2 is restarted on a
+ *            one-tick period (the ticks elapsed in the running period are
+ *            counted, the fraction of a tick is lost).
+ * @param[in] SLEPT_MS: Time slept in ms, from \ref HAL_PowerDown().
+ *********************************************************************/
+static void cuteOS_PowerResync(const u32_t SLEPT_MS) {
+    /*!< SLEPT_MS = q * tick time + r: the ms are converted to time units without overflow */
+    const u32_t rest = (((SLEPT_MS % cuteOS_tick_time) * UNITS_PER_MS) + cuteOS_power_down_rest);
+    const u32_t ticks = ((SLEPT_MS / cuteOS_tick_time) * UNITS_PER_MS) + (rest / cuteOS_tick_time);
+    u32_t late;
+    u8_t i;
+#if CUTEOS_CFG_TICKLESS
+    u16_t increments;
+#endif
+
+    cuteOS_power_down_rest = (u16_t)(rest % cuteOS_tick_time);
+    if(ticks != 0) {
+        HAL_INT_DISABLE();
+#if CUTEOS_CFG_TICKLESS
+        increments = cuteOS_ReadTime(&late);
+        cuteOS_tick_count = late + (increments / cuteOS_tick_increments);
+        cuteOS_step = 1;
+        cuteOS_step_next = 1;
+#endif
+        cuteOS_tick_count += ticks;
+
+        for(i = 0; i < (WHEEL_LEVELS * WHEEL_SLOTS); ++i) {
+            cuteOS_wheel[i] = TASK_NONE;
+        }
+        for(i = 0; i < cuteOS_task_top; ++i) {
+            if(tasks[i].slot != TASK_NONE) {
+                late = cuteOS_tick_count - tasks[i].expiry;
+                if(late < 0x80000000UL) {      /*!< Due while sleeping, or now */
+                    if(0 == (cuteOS_ready_tasks[i >> 3] & cuteOS_bit_mask[i & 0x07])) {
+                        cuteOS_ReadyAppend(i);
+                    }
+                    tasks[i].expiry += ((late / tasks[i].ticks) + 1) * tasks[i].ticks;
+                }
+                cuteOS_WheelInsert(i);
+            }
+        }
+
+#if CUTEOS_CFG_TIMERS
+        /*!< The timers due are the first ones: expiring now keeps the order */
+        for(i = cuteOS_timer_head; (i != TASK_NONE) && ((cuteOS_tick_count - cuteOS_timers[i].expiry) < 0x80000000UL); i = cuteOS_timers[i].next) {
+            cuteOS_timers[i].expiry = cuteOS_tick_count;
+        }
+        if( (cuteOS_timer_head != TASK_NONE) && (cuteOS_timers[cuteOS_timer_head].expiry == cuteOS_tick_count) ) {
+            cuteOS_TimerExpire();
+        }
+#endif
+
+#if CUTEOS_CFG_TICKLESS
+        HAL_TimerStart(HAL_TIMER_RELOAD(cuteOS_tick_increments), cuteOS_ISR);  /*!< Enables the interrupts */
+#else
+        HAL_INT_ENABLE();
+#endif
+    }
+}
+#endif
+
+/**********************************************************************
+ * @brief   Read the tick count and the Timer 2 increments since that tick.
+ * @details The 32-bit tick count and the Timer 2 count are read without
+ *          disabling the interrupts: if the ISR changes the tick count
+ *          meanwhile, they are read again. If Timer 2 overflowed but its
+ *          interrupt is still pending (the interrupts are disabled, or the
+ *          ISR did not start yet), the tick count has not been incremented
+ *          yet: the period that started at the overflow is used.
+ *          The increments since the tick are the Timer 2 count minus the
+ *          reload value of the running period (in tickless mode, or after
+ *          a tick time switch, a period covers several ticks, so they may
+ *          exceed one tick).
+ * @param[out] \c ptr_ticks: The tick count.
+ * @return  \c u16_t: The Timer 2 increments since that tick.
+ *********************************************************************/
+static u16_t cuteOS_ReadTime(u32_t * const ptr_ticks) {
+    u32_t tick_count;
+    u32_t ticks;
+    u16_t count;
+    u16_t step;
+    u16_t step_next;
+
+    do {
+        tick_count = cuteOS_tick_count;
+        ticks = tick_count;
+        step = cuteOS_step;
+        step_next = cuteOS_step_next;
+        count = HAL_TimerRead();
+        if(HAL_TimerOverflowPending()) {
+            count = HAL_TimerRead();
+            ticks += step;
+            step = step_next;
+        }
+    } while(tick_count != cuteOS_tick_count);     /*!< The ISR ran meanwhile */
+
+    *ptr_ticks = ticks;
+
+    return count - HAL_TIMER_RELOAD((u32_t)step * cuteOS_tick_increments);
+}
+
+#if CUTEOS_CFG_TASK_STATS || CUTEOS_CFG_LOAD_STATS || CUTEOS_CFG_TRACE
+/**********************************************************************
+ * @brief   Get the current time in Timer 2 increments.
+ * @return  \c u32_t: The time in Timer 2 increments (wraps around).
+ *********************************************************************/
+static u32_t cuteOS_Timestamp(void) {
+    u32_t ticks;
+    const u16_t increments = cuteOS_ReadTime(&ticks);
+
+    return (ticks * cuteOS_tick_increments) + increments;
+}
+#endif
+
+#if CUTEOS_CFG_TASK_STATS
+
+/**********************************************************************
+ * @brief   Add one run of \c cycles to the statistics of a task.
+ *********************************************************************/
+static void cuteOS_StatsUpdate(const u8_t index, const u32_t cycles) {
+    cuteOS_TASK_STATS_t HAL_XDATA * const stats = &tasks[index].stats;
+
+    if(cycles < stats->min_cycles) {
+        stats->min_cycles = cycles;
+    }
+    if(cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+    if(0 == stats->runs) {
+        stats->avg_cycles = cycles;
+    } else {
+        stats->avg_cycles = stats->avg_cycles - (stats->avg_cycles >> 3) + (cycles >> 3);
+    }
+    if(stats->runs != 0xFFFF) {
+        ++stats->runs;
+    }
+}
+#endif
+
+#if CUTEOS_CFG_LOAD_STATS
+/**********************************************************************
+ * @brief   Add idle time to the running CPU load window, and close the
+ *          window when it is over.
+ * @details The load of a window is (elapsed - idle) / elapsed in per
+ *          mille. The elapsed time may exceed the window (long tasks), so
+ *          both are scaled down to keep the product by 1000 in 32 bits.
+ * @param[in] now: The current time (\ref cuteOS_Timestamp()).
+ * @param[in] idle_cycles: Idle increments since the last call.
+ *********************************************************************/
+static void cuteOS_LoadUpdate(const u32_t now, const u32_t idle_cycles) {
+    cuteOS_LOAD_STATS_t * const stats = &cuteOS_load_stats;
+    u32_t elapsed = now - cuteOS_load_start;
+    u32_t idle = cuteOS_load_idle + idle_cycles;
+    u16_t load;
+
+    if(elapsed < LOAD_WINDOW_INC) {
+        cuteOS_load_idle = idle;
+    } else {
+        while(elapsed > 0x3FFFFFUL) {
+            elapsed >>= 1;
+            idle >>= 1;
+        }
+        load = (idle >= elapsed) ? 0 : (u16_t)(((elapsed - idle) * 1000UL) / elapsed);
+
+        stats->load_last = load;
+        if(load > stats->load_peak) {
+            stats->load_peak = load;
+        }
+        if(0 == stats->windows) {
+            stats->load_avg = load;
+        } else {
+            stats->load_avg = stats->load_avg - (stats->load_avg >> 3) + (load >> 3);
+        }
+        if(stats->windows != 0xFFFF) {
+            ++stats->windows;
+        }
+
+        cuteOS_load_start = now;
+        cuteOS_load_idle = 0;
+    }
+}
+#endif
+
+/**********************************************************************
+ * @brief   Mark a task as ready: append it to the ready list of its priority.
+ * @note    Called with the Timer 2 interrupt disabled or from the ISR.
+ *          Excluded from the Keil data overlay (see \ref cuteOS_ISR()).
+ *********************************************************************/
+static void cuteOS_ReadyAppend(const u8_t index) {
+    const u8_t priority = tasks[index].priority;
+
+    cuteOS_ready_tasks[index >> 3] |= cuteOS_bit_mask[index & 0x07];
+
+    tasks[index].ready_next = TASK_NONE;
+    tasks[index].ready_prev = cuteOS_ready_tail[priority];
+    if(TASK_NONE == cuteOS_ready_tail[priority]) {
+        cuteOS_ready_head[priority] = index;
+    } else {
+        tasks[cuteOS_ready_tail[priority]].ready_next = index;
+    }
+    cuteOS_ready_tail[priority] = index;
+    cuteOS_ready_prio |= cuteOS_bit_mask[priority];
+}
+
+/**********************************************************************
+ * @brief   Drop the pending release of a task, if any.
+ * @details The ready lists are doubly linked, so it takes constant time.
+ * @note    Called with the Timer 2 interrupt disabled.
+ *********************************************************************/
+static void cuteOS_ReadyUnlink(const u8_t index) {
+    const u8_t priority = tasks[index].priority;
+    const u8_t next = tasks[index].ready_next;
+    const u8_t prev = tasks[index].ready_prev;
+
+    if(cuteOS_ready_tasks[index >> 3] & cuteOS_bit_mask[index & 0x07]) {
+        cuteOS_ready_tasks[index >> 3] &= (u8_t)~cuteOS_bit_mask[index & 0x07];
+
+        if(TASK_NONE == prev) {
+            cuteOS_ready_head[priority] = next;
+        } else {
+            tasks[prev].ready_next = next;
+        }
+        if(TASK_NONE == next) {
+            cuteOS_ready_tail[priority] = prev;
+        } else {
+            tasks[next].ready_prev = prev;
+        }
+        if(TASK_NONE == cuteOS_ready_head[priority]) {
+            cuteOS_ready_prio &= (u8_t)~cuteOS_bit_mask[priority];
+        }
+    }
+}
+
+#if CUTEOS_CFG_EVENTS
+/**********************************************************************
+ * @brief   Unlink a task from the list of the event tasks, if it is linked.
+ * @note    Called with the Timer 2 interrupt disabled.
+ *********************************************************************/
+static void cuteOS_EventUnlink(const u8_t index) {
+    const u8_t next = tasks[index].event_next;
+    const u8_t prev = tasks[index].event_prev;
+
+    if(tasks[index].event_mask != 0) {
+        if(TASK_NONE == prev) {
+            cuteOS_event_tasks = next;
+        } else {
+            tasks[prev].event_next = next;
+        }
+        if(next != TASK_NONE) {
+            tasks[next].event_prev = prev;
+        }
+        tasks[index].event_mask = 0;
+    }
+}
+#endif
+
+/**********************************************************************
+ * @brief   Assign the rate-monotonic priorities.
+ * @details The priority of a task created with \ref CUTEOS_PRIO_AUTO is
+ *          the number of distinct shorter periods among all the tasks, so
+ *          the shortest period gets priority 0. Priorities beyond
+ *          \ref CUTEOS_PRIO_LOWEST are clamped to it, so only the
+ *          \ref RM_PERIODS shortest distinct periods matter: they are
+ *          sorted in \ref cuteOS_rm_periods in one pass over the tasks,
+ *          then the priority of a task is the number of them shorter than
+ *          its period. It takes time proportional to the number of tasks
+ *          times \ref RM_PERIODS, and it runs at each task created or
+ *          period changed after \ref cuteOS_Start().
+ * @note    A task whose priority changes has its pending release moved to
+ *          the ready list of its new priority. The others are not touched.
+ *********************************************************************/
+static void cuteOS_UpdatePriorities(void) {
+    BOOL_t ready;
+    u8_t periods = 0;
+    u8_t priority;
+    u8_t i;
+    u8_t j;
+    u8_t k;
+
+    /*!< Insert the period of each periodic task in the table, if it is among the shortest distinct ones */
+    for(i = 0; i < cuteOS_task_top; ++i) {
+        if(NULL == tasks[i].callback) {
+            continue;
+        }
+#if CUTEOS_CFG_EVENTS
+        if(tasks[i].event_mask != 0) {
+            continue;   /*!< The timeout of an event task is not a period */
+        }
+#endif
+        for(j = 0; (j < periods) && (cuteOS_rm_periods[j] < tasks[i].period); ++j) {
+        }
+        if( (j < RM_PERIODS) && ((j == periods) || (cuteOS_rm_periods[j] != tasks[i].period)) ) {
+            if(periods < RM_PERIODS) {
+                ++periods;
+            }
+            for(k = periods - 1; k > j; --k) {
+                cuteOS_rm_periods[k] = cuteOS_rm_periods[k - 1];     /*!< The longest one falls out of a full table */
+            }
+            cuteOS_rm_periods[j] = tasks[i].period;
+        }
+    }
+
+    for(i = 0; i < cuteOS_task_top; ++i) {
+        if( (NULL == tasks[i].callback) || (tasks[i].base_priority != CUTEOS_PRIO_AUTO) ) {
+            continue;
+        }
+
+        /*!< Count the distinct periods shorter than the period of task i: all the table gives CUTEOS_PRIO_LOWEST */
+        for(priority = 0; (priority < periods) && (cuteOS_rm_periods[priority] < tasks[i].period); ++priority) {
+        }
+
+        if(priority != tasks[i].priority) {
+            HAL_INT_DISABLE();
+            ready = (cuteOS_ready_tasks[i >> 3] & cuteOS_bit_mask[i & 0x07]) ? TRUE : FALSE;
+            cuteOS_ReadyUnlink(i);
+            tasks[i].priority = priority;
+            if(TRUE == ready) {
+                cuteOS_ReadyAppend(i);
+            }
+            HAL_INT_ENABLE();
+        }
+    }
+}
+
+#if CUTEOS_CFG_TIMERS
+/**********************************************************************
+ * @brief   Find the timer of a callback.
+ * @param[in] callback: Pointer to the timer function, NULL finds a free timer.
+ * @return  \c u8_t: Index of the timer, or \ref TASK_NONE if not found.
+ *********************************************************************/
+static u8_t cuteOS_TimerFind(ERROR_t (* const callback)(void)) {
+    u8_t i;
+
+    for(i = 0; i < CUTEOS_CFG_TIMERS; ++i) {
+        if(cuteOS_timers[i].callback == callback) {
+            return i;
+        }
+    }
+
+    return TASK_NONE;
+}
+
+/**********************************************************************
+ * @brief   Convert a duration in time units to ticks, rounded up (at least 1 tick).
+ *********************************************************************/
+static u32_t cuteOS_TimerTicks(const u32_t TIME) {
+    u32_t ticks;
+    u16_t tick_time;
+
+    (void)cuteOS_GetTickTime(&tick_time);
+    ticks = (TIME / tick_time) + (((TIME % tick_time) != 0) ? 1 : 0);
+
+    return (0 == ticks) ? 1 : ticks;
+}
+
+/**********************************************************************
+ * @brief   Link an unlinked timer in the expiry list, its duration from now.
+ * @details In tickless mode, the tick count is only updated at the end of
+ *          a Timer 2 period covering several ticks, so the ticks elapsed
+ *          in the running period are added. The list walk runs with the
+ *          interrupts enabled between its steps (see \ref cuteOS_TimerInsert()).
+ *********************************************************************/
+static void cuteOS_TimerArm(const u8_t index) {
+    const u32_t ticks = cuteOS_TimerTicks(cuteOS_timers[index].duration);
+    u32_t now;
+#if CUTEOS_CFG_TICKLESS
+    u16_t increments;
+#endif
+
+    HAL_INT_DISABLE();
+#if CUTEOS_CFG_TICKLESS
+    increments = cuteOS_ReadTime(&now);
+    if(cuteOS_tick_increments != 0) {
+        now += increments / cuteOS_tick_increments;
+    }
+#else
+    now = cuteOS_tick_count;
+#endif
+    cuteOS_timers[index].ticks = ticks;
+    cuteOS_timers[index].expiry = now + ticks;
+    HAL_INT_ENABLE();
+
+    cuteOS_TimerInsert(index);
+}
+
+/**********************************************************************
+ * @brief   Link a timer in the expiry list, after the timers expiring
+ *          before it or at the same tick.
+ * @details The list is walked one timer per step, each step with the
+ *          interrupts disabled, so the ISR waits at most one step. The ISR
+ *          only takes the expired timers from the head of the list:
+ *          - If the timer reached by the walk was taken meanwhile, the walk
+ *            starts again from the head, which is still before the timer.
+ *          - If the expiry of the timer itself passed meanwhile (or before
+ *            the call, after a long callback), a one-shot timer expires at
+ *            the next tick, and an auto-reload timer skips the expiries
+ *            missed, counted as overruns (\ref cuteOS_GetOverruns()). It
+ *            is never linked behind the tick count, where the ISR would
+ *            not see it.
+ * @note    Called from the tasks only. When the caller disabled the
+ *          interrupts, they stay disabled for the whole walk.
+ *********************************************************************/
+static void cuteOS_TimerInsert(const u8_t index) {
+    u32_t late;
+    u32_t missed;
+    u8_t prev = TASK_NONE;
+    u8_t i;
+    u8_t ea;
+    BOOL_t linked = FALSE;
+
+    do {
+        HAL_INT_SAVE(ea);
+        late = cuteOS_tick_count - cuteOS_timers[index].expiry;
+        if(late < 0x80000000UL) {
+            if(CUTEOS_TIMER_AUTO_RELOAD == cuteOS_timers[index].mode) {
+                missed = (late / cuteOS_timers[index].ticks) + 1;
+                cuteOS_timers[index].expiry += missed * cuteOS_timers[index].ticks;
+                cuteOS_overruns += (u16_t)missed;
+            } else {
+                cuteOS_timers[index].expiry = cuteOS_tick_count + 1;
+            }
+        }
+
+        if( (prev != TASK_NONE) && (0 == (cuteOS_timers[prev].state & TIMER_ARMED)) ) {
+            prev = TASK_NONE;
+        }
+        i = (TASK_NONE == prev) ? cuteOS_timer_head : cuteOS_timers[prev].next;
+
+        if( (TASK_NONE == i) ||
+            ((cuteOS_timers[i].expiry - cuteOS_tick_count) > (cuteOS_timers[index].expiry - cuteOS_tick_count)) ) {
+            cuteOS_timers[index].next = i;
+            if(TASK_NONE == prev) {
+                cuteOS_timer_head = index;
+            } else {
+                cuteOS_timers[prev].next = index;
+            }
+            cuteOS_timers[index].state |= TIMER_ARMED;
+            TIMER_DUE_UPDATE();
+            linked = TRUE;
+        } else {
+            prev = i;
+        }
+        HAL_INT_RESTORE(ea);
+    } while(FALSE == linked);
+}
+
+/**********************************************************************
+ * @brief   Unlink a timer from the expiry list, if it is armed, and cancel
+ *          its pending reload.
+ * @note    Called with the Timer 2 interrupt disabled.
+ *********************************************************************/
+static void cuteOS_TimerUnlink(const u8_t index) {
+    u8_t prev = TASK_NONE;
+    u8_t i;
+
+    if(cuteOS_timers[index].state & TIMER_ARMED) {
+        for(i = cuteOS_timer_head; i != index; i = cuteOS_timers[i].next) {
+            prev = i;
+        }
+
+        if(TASK_NONE == prev) {
+            cuteOS_timer_head = cuteOS_timers[index].next;
+        } else {
+            cuteOS_timers[prev].next = cuteOS_timers[index].next;
+        }
+        cuteOS_timers[index].state &= (u8_t)~TIMER_ARMED;
+        TIMER_DUE_UPDATE();
+    }
+    cuteOS_timers[index].state &= (u8_t)~TIMER_RELOAD;
+}
+
+/**********************************************************************
+ * @brief   Move the timers expiring now to the fired list.
+ * @details Called by \ref cuteOS_ISR() when the first timer expires. Each
+ *          expired timer is taken from the head of the list, so the ISR
+ *          does not walk the list. The auto-reload timers get their next
+ *          expiry, one duration later, and are linked again by
+ *          \ref cuteOS_TimerRun() after their callback. A timer expiring
+ *          while its previous run is still pending counts as an overrun
+ *          (\ref cuteOS_GetOverruns()).
+ * @note    Also called by \ref cuteOS_PowerResync() with the interrupts
+ *          disabled: excluded from the Keil data overlay (see \ref cuteOS_ISR()).
+ *********************************************************************/
+static void cuteOS_TimerExpire(void) {
+    u8_t index;
+
+    do {
+        index = cuteOS_timer_head;
+        cuteOS_timer_head = cuteOS_timers[index].next;
+        cuteOS_timers[index].state &= (u8_t)~TIMER_ARMED;
+
+        if(cuteOS_timers[index].state & TIMER_FIRED) {
+            ++cuteOS_overruns;      /*!< Previous expiry did not run yet */
+        } else {
+            cuteOS_timers[index].state |= TIMER_FIRED;
+            cuteOS_timers[index].fired_next = TASK_NONE;
+            if(TASK_NONE == cuteOS_timer_fired_tail) {
+                cuteOS_timer_fired = index;
+            } else {
+                cuteOS_timers[cuteOS_timer_fired_tail].fired_next = index;
+            }
+            cuteOS_timer_fired_tail = index;
+        }
+
+        if(CUTEOS_TIMER_AUTO_RELOAD == cuteOS_timers[index].mode) {
+            cuteOS_timers[index].expiry += cuteOS_timers[index].ticks;
+            cuteOS_timers[index].state |= TIMER_RELOAD;
+        }
+    } while( (cuteOS_timer_head != TASK_NONE) && (cuteOS_timers[cuteOS_timer_head].expiry == cuteOS_tick_count) );
+    TIMER_DUE_UPDATE();
+}
+
+/**********************************************************************
+ * @brief   Run the callback of the first expired timer.
+ * @details Called by \ref cuteOS_Dispatch() when the fired list is not
+ *          empty. The timer is taken from the list with the interrupts
+ *          disabled, then its callback runs with the interrupts enabled,
+ *          so it may start, restart or stop any timer. An auto-reload
+ *          timer is then linked again at its next expiry, unless its
+ *          callback started, restarted or stopped it.
+ *********************************************************************/
+static void cuteOS_TimerRun(void) {
+    ERROR_t (*callback)(void);
+    u8_t index;
+    u8_t reload;
+
+    HAL_INT_DISABLE();
+    index = cuteOS_timer_fired;
+    cuteOS_timer_fired = cuteOS_timers[index].fired_next;
+    if(TASK_NONE == cuteOS_timer_fired) {
+        cuteOS_timer_fired_tail = TASK_NONE;
+    }
+    cuteOS_timers[index].state &= (u8_t)~TIMER_FIRED;
+    callback = cuteOS_timers[index].callback;
+    TRACE(CUTEOS_TRACE_TIMER_START, index, cuteOS_Timestamp());
+    HAL_INT_ENABLE();
+
+    if(callback != NULL) {
+        callback();
+    }
+    TRACE_TASK(CUTEOS_TRACE_TIMER_END, index);
+
+    HAL_INT_DISABLE();
+    reload = cuteOS_timers[index].state & TIMER_RELOAD;
+    cuteOS_timers[index].state &= (u8_t)~TIMER_RELOAD;
+    HAL_INT_ENABLE();
+
+    if(reload != 0) {
+        cuteOS_TimerInsert(index);
+    }
+}
+
+#if !CUTEOS_CFG_STATIC
+/**********************************************************************
+ * @brief   Convert the armed timers to a new tick time.
+ * @details Called by \ref cuteOS_UpdateTicks() after the tick time changed.
+ *          The time left is kept (rounded up to the new ticks, and at most
+ *          the duration), which also scales the timers started before
+ *          \ref cuteOS_Start(), and the expired ones waiting for their
+ *          reload. The armed timers are linked again in the expiry list,
+ *          in the order of their new expiries.
+ * @param[in] OLD_TICK_TIME: The tick time the timers were armed with.
+ *********************************************************************/
+static void cuteOS_TimerRescale(const u16_t OLD_TICK_TIME) {
+    u32_t left;
+    u8_t next;
+    u8_t i;
+
+    HAL_INT_DISABLE();
+    for(i = 0; i < CUTEOS_CFG_TIMERS; ++i) {
+        if(cuteOS_timers[i].state & (TIMER_ARMED | TIMER_RELOAD)) {
+            left = (cuteOS_timers[i].expiry - cuteOS_tick_count) * OLD_TICK_TIME;
+            if(left > cuteOS_timers[i].duration) {
+                left = cuteOS_timers[i].duration;     /*!< Rounding error of the old ticks, or late */
+            }
+            cuteOS_timers[i].ticks = cuteOS_TimerTicks(cuteOS_timers[i].duration);
+            cuteOS_timers[i].expiry = cuteOS_tick_count + cuteOS_TimerTicks(left);
+        }
+    }
+
+    i = cuteOS_timer_head;
+    cuteOS_timer_head = TASK_NONE;
+    for(; i != TASK_NONE; i = next) {
+        next = cuteOS_timers[i].next;
+        cuteOS_TimerInsert(i);
+    }
+    HAL_INT_ENABLE();
+}
+#endif
+#endif
+
+#if CUTEOS_CFG_STATIC
+/**********************************************************************
+ * @brief   Load the static task set from CODE memory.
+ * @details The tick time and the number of ticks of each task are already
+ *          computed by the compiler: the tasks are copied to the tasks
+ *          array, their rate-monotonic priorities are set, their offsets
+ *          are balanced (\ref CUTEOS_CFG_BALANCE), then they are linked
+ *          in the timing wheel.
+ *********************************************************************/
+static void cuteOS_StaticLoad(void) {
+    u8_t i;
+
+    for(i = 0; i < MAX_TASKS_NUM; ++i) {
+        tasks[i].id = i;
+        tasks[i].period = cuteOS_static_tasks[i].period;
+        tasks[i].ticks = cuteOS_static_tasks[i].ticks;
+#if CUTEOS_CFG_BALANCE
+        tasks[i].offset = CUTEOS_OFFSET_AUTO;
+        tasks[i].phase = PHASE_UNPLACED;
+#else
+        tasks[i].offset = 0;
+        tasks[i].phase = 0;
+#endif
+        tasks[i].base_priority = cuteOS_static_tasks[i].priority;
+        tasks[i].priority = (CUTEOS_PRIO_AUTO == tasks[i].base_priority) ? CUTEOS_PRIO_LOWEST : tasks[i].base_priority;
+        tasks[i].suspended = FALSE;
+#if CUTEOS_CFG_EVENTS
+        tasks[i].event_mask = 0;
+        tasks[i].events = 0;
+#endif
+#if CUTEOS_CFG_TASK_STATS
+        tasks[i].stats.min_cycles = 0xFFFFFFFFUL;
+        tasks[i].stats.max_cycles = 0;
+        tasks[i].stats.avg_cycles = 0;
+        tasks[i].stats.runs = 0;
+#endif
+        tasks[i].callback = cuteOS_static_tasks[i].callback;
+    }
+    cuteOS_task_counter = MAX_TASKS_NUM;
+    cuteOS_task_top = MAX_TASKS_NUM;
+
+    cuteOS_UpdatePriorities();
+
+#if CUTEOS_CFG_BALANCE
+    cuteOS_Balance();
+#endif
+
+    HAL_INT_DISABLE();
+    for(i = 0; i < MAX_TASKS_NUM; ++i) {
+        tasks[i].expiry = cuteOS_tick_count + ((0 == tasks[i].phase) ? tasks[i].ticks : tasks[i].phase);
+        cuteOS_WheelInsert(i);
+    }
+    HAL_INT_ENABLE();
+}
+#else
+/**********************************************************************
+ * @brief   Find a free slot in the tasks array and set up a task in it.
+ * @details This function does the following:
+ *          - Take a free slot in the tasks array (see \ref cuteOS_task_free).
+ *          - Increment the task counter.
+ *          - Set the task ID.
+ *          - Set the period, the release offset and the priority of the
+ *            task (the parameters are already checked).
+ *          - Set the pointer to the task function, last.
+ *          The task is not linked in the timing wheel: it is linked by
+ *          \ref cuteOS_UpdateTicks(), or by \ref cuteOS_TaskSchedule()
+ *          after \ref cuteOS_Start().
+ * @return  \c u8_t: Index of the task, or \ref TASK_NONE if the tasks
+ *          array is full.
+ *********************************************************************/
+static u8_t cuteOS_TaskAlloc(ERROR_t (* const callback)(void), const u32_t PERIOD, const u8_t PRIORITY, const u32_t OFFSET) {
+    u8_t i;
+
+    /*!< Take a free slot, or a slot never used */
+    if(cuteOS_task_free != TASK_NONE) {
+        i = cuteOS_task_free;
+        cuteOS_task_free = tasks[i].next;
+    } else if(cuteOS_task_top < MAX_TASKS_NUM) {
+        i = cuteOS_task_top++;
+    } else {
+        return TASK_NONE;
+    }
+
+    ++cuteOS_task_counter;
+    tasks[i].id = i;
+    tasks[i].period = PERIOD;
+    tasks[i].offset = OFFSET;
+    tasks[i].ticks = 0;
+    tasks[i].slot = TASK_NONE;
+    tasks[i].suspended = FALSE;
+    tasks[i].base_priority = PRIORITY;
+    tasks[i].priority = (PRIORITY == CUTEOS_PRIO_AUTO) ? CUTEOS_PRIO_LOWEST : PRIORITY;
+#if CUTEOS_CFG_EVENTS
+    tasks[i].event_mask = 0;
+    tasks[i].events = 0;
+#endif
+#if CUTEOS_CFG_TASK_STATS
+    tasks[i].stats.min_cycles = 0xFFFFFFFFUL;
+    tasks[i].stats.max_cycles = 0;
+    tasks[i].stats.avg_cycles = 0;
+    tasks[i].stats.runs = 0;
+#endif
+    tasks[i].callback = callback;
+    TRACE_TASK(CUTEOS_TRACE_TASK_CREATE, i);
+
+    return i;
+}
+
+/**********************************************************************
+ * @details Compute the tick time as the GCD of the periods, then link all
+ *          the tasks again in the timing wheel (emptied by \ref cuteOS_Init()),
+ *          one period from now. The software timers are converted to the
+ *          new tick time.
+ *********************************************************************/
+static ERROR_t cuteOS_UpdateTicks(void) {
+    ERROR_t error = ERROR_NO;
+    u32_t gcd;
+    u8_t i;
+#if CUTEOS_CFG_TIMERS
+    u16_t old_tick_time;
+
+    error |= cuteOS_GetTickTime(&old_tick_time);
+#endif
+
+    /*!< Find the maximum tick time among all the tasks */
+    error |= cuteOS_GCD(&gcd);
+
+    error |= cuteOS_SetTickTime(gcd);
+    gcd = cuteOS_tick_time;    /*!< The tick time set: the GCD is 0 when no task has a period (event tasks without timeout) */
+
+#if CUTEOS_CFG_TIMERS
+    cuteOS_TimerRescale(old_tick_time);     /*!< The running timers keep their remaining time */
+#endif
+
+    cuteOS_UpdatePriorities();
+
+#if CUTEOS_CFG_HYBRID
+    HAL_INT_DISABLE();
+    if(cuteOS_hp_callback != NULL) {
+        if( (cuteOS_hp_period / gcd) > 0xFFFF ) {
+            cuteOS_hp_callback = NULL;
+            error |= ERROR_OUT_OF_RANGE;
+        }
+        cuteOS_hp_ticks = (u16_t)(cuteOS_hp_period / gcd);
+    } else {
+        cuteOS_hp_ticks = 0xFFFF;   /*!< No preemptive task: keep its countdown far from zero */
+    }
+    cuteOS_hp_remaining = cuteOS_hp_ticks;
+    HAL_INT_ENABLE();
+#endif
+
+    /*!< Update the number of ticks and the offset of each task (they are not linked in the wheel yet) */
+    for(i = 0; i < MAX_TASKS_NUM; ++i) {
+        if(tasks[i].callback != NULL) {
+            tasks[i].ticks = tasks[i].period / gcd;
+            if(CUTEOS_OFFSET_AUTO == tasks[i].offset) {
+#if CUTEOS_CFG_BALANCE
+                tasks[i].phase = PHASE_UNPLACED;
+#else
+                tasks[i].phase = 0;
+#endif
+            } else {
+                tasks[i].phase = tasks[i].offset / gcd;
+            }
+        }
+    }
+
+#if CUTEOS_CFG_BALANCE
+    cuteOS_Balance();
+#endif
+
+    /*!< Link each task at its first release: after its offset, or one period from now */
+    HAL_INT_DISABLE();
+    cuteOS_origin = cuteOS_tick_count;
+    for(i = 0; i < MAX_TASKS_NUM; ++i) {
+        if( (tasks[i].callback != NULL) && (tasks[i].ticks != 0) ) {     /*!< An event task without timeout is not linked */
+            tasks[i].expiry = cuteOS_tick_count + ((0 == tasks[i].phase) ? tasks[i].ticks : tasks[i].phase);
+            if(FALSE == tasks[i].suspended) {
+                cuteOS_WheelInsert(i);
+            }
+        }
+    }
+    HAL_INT_ENABLE();
+
+    return error;
+}
+
+static ERROR_t cuteOS_GCD(u32_t *gcd) {
+    ERROR_t error = ERROR_NO;
+    u8_t i;
+
+    *gcd = 0;
+#if CUTEOS_CFG_HYBRID
+    if(cuteOS_hp_callback != NULL) {
+        *gcd = cuteOS_hp_period;
+    }
+#endif
+    for(i = 0; i < MAX_TASKS_NUM; ++i) {
+        if(NULL == tasks[i].callback) {
+            continue;
+        }
+        *gcd = cuteOS_GCD2(*gcd, tasks[i].period);
+        if( (tasks[i].offset != CUTEOS_OFFSET_AUTO) && (tasks[i].offset != 0) ) {
+            *gcd = cuteOS_GCD2(*gcd, tasks[i].offset);   /*!< The offset must be a whole number of ticks */
+        }
+    }
+
+    /*!< Check if the tick time is greater than the maximum tick time */
+    i = 2;
+    while(*gcd > CUTEOS_MAX_TICK_TIME) {
+        while( (*gcd % i) != 0) {
+            ++i;
+        }
+        *gcd /= i;
+    }
+
+    return error;
+}
+
+/**********************************************************************
+ * @details Set the value of the tick time in time units. So, the
+ *          timing of the tasks is determined by the frequency of Timer 2
+ *          overflow. Overflow occurs every tick time.
+ *********************************************************************/
+static ERROR_t cuteOS_SetTickTime(const u32_t TICK_TIME){
+    ERROR_t error = ERROR_NO;
+    
+    if(TICK_TIME <= CUTEOS_MAX_TICK_TIME) {
+		if(TICK_TIME <= 1) {
+			cuteOS_tick_time = 1;
+		} else {
+			cuteOS_tick_time = (u16_t)TICK_TIME;
+		}
+        error |= cuteOS_Init();
+    } else {
+        error |= ERROR_OUT_OF_RANGE;
+    }
+
+    return error;
+}
+
+/**********************************************************************
+ * @brief   Make the tick time divide a new period or offset, after
+ *          \ref cuteOS_Start().
+ * @details The new tick time is the GCD of the current one and \c TIME, so
+ *          it still divides all the other periods: no GCD over all the
+ *          tasks is needed, and Timer 2 is only reprogrammed when the
+ *          tick time really changes (\ref cuteOS_TickSwitch()).
+ * @param[in] TIME: The period or offset in time units, 0 fits any tick time.
+ * @return  \c ERROR_t: \ref ERROR_OUT_OF_RANGE if the period of the
+ *          preemptive task would not fit in 16-bit ticks. The tick time
+ *          is not changed then.
+ *********************************************************************/
+static ERROR_t cuteOS_TickFit(const u32_t TIME) {
+    ERROR_t error = ERROR_NO;
+    const u16_t tick_time = (u16_t)cuteOS_GCD2(cuteOS_tick_time, TIME);
+
+    if(tick_time != cuteOS_tick_time) {
+#if CUTEOS_CFG_HYBRID
+        if( (cuteOS_hp_callback != NULL) && ((cuteOS_hp_period / tick_time) > 0xFFFF) ) {
+            error |= ERROR_OUT_OF_RANGE;
+        } else
+#endif
+        {
+            cuteOS_TickSwitch(tick_time);
+        }
+    }
+
+    return error;
+}
+
+/**********************************************************************
+ * @brief   Switch to a tick time that divides the current one, without
+ *          stopping Timer 2.
+ * @details With k = old tick time / new tick time, every tick count is
+ *          multiplied by k: the tick count, the origin of the offsets, the
+ *          expiries and phases of the tasks, the expiries of the timers
+ *          and the countdown of the preemptive task. So, all the releases
+ *          keep their times, and the time read by \ref cuteOS_GetTimeUs()
+ *          goes on smoothly. The timing wheel is built again from the new
+ *          expiries.
+ *
+ *          Timer 2 is never stopped nor its count written: the running
+ *          period was loaded with the old tick time, so it covers k new
+ *          ticks (\ref cuteOS_step), and the new tick time is written to
+ *          the reload registers for the next period. So, the switch
+ *          happens at the next overflow, a tick boundary of both tick
+ *          times. If the overflow is too close to write both reload bytes
+ *          safely, it is waited for. If it is already pending, the next
+ *          period is an old one too (\ref cuteOS_step_next): the ISR loads
+ *          the new tick time after it.
+ *
+ *          The releases falling inside the running old period, only those
+ *          of a new or changed task, are delayed to its end.
+ * @param[in] TICK_TIME: The new tick time, a divisor of the current one.
+ * @note    Takes time proportional to the number of tasks, with the
+ *          interrupts disabled.
+ *********************************************************************/
+static void cuteOS_TickSwitch(const u16_t TICK_TIME) {
+    const u16_t k = cuteOS_tick_time / TICK_TIME;
+    u8_t i;
+
+    HAL_INT_DISABLE();
+    cuteOS_tick_time = TICK_TIME;
+    cuteOS_tick_increments = TICK_INCREMENTS(TICK_TIME);
+#if CUTEOS_CFG_TICKLESS
+    cuteOS_max_step = (65536UL / cuteOS_tick_increments > WHEEL_SLOTS) ? WHEEL_SLOTS : (u8_t)(65536UL / cuteOS_tick_increments);
+#endif
+    cuteOS_step *= k;
+    cuteOS_step_next *= k;
+    cuteOS_tick_count *= k;
+    cuteOS_origin *= k;
+
+    while( (FALSE == HAL_TimerOverflowPending()) && (HAL_TimerRead() >= HAL_TIMER_RELOAD(RELOAD_MARGIN_INC)) ) {
+        /*!< Wait for the overflow, the reload registers are about to be used */
+    }
+    if(FALSE == HAL_TimerOverflowPending()) {
+        cuteOS_step_next = 1;
+        HAL_TimerSetReload(HAL_TIMER_RELOAD(cuteOS_tick_increments));
+    }
+
+#if CUTEOS_CFG_HYBRID
+    if(cuteOS_hp_callback != NULL) {
+        cuteOS_hp_ticks = (u16_t)(cuteOS_hp_period / TICK_TIME);
+        cuteOS_hp_remaining *= k;
+    }
+#endif
+
+    /*!< Scale the tasks and link the linked ones again */
+    for(i = 0; i < (WHEEL_LEVELS * WHEEL_SLOTS); ++i) {
+        cuteOS_wheel[i] = TASK_NONE;
+    }
+    for(i = 0; i < cuteOS_task_top; ++i) {
+        if(tasks[i].callback != NULL) {
+            tasks[i].ticks = tasks[i].period / TICK_TIME;
+            tasks[i].phase *= k;
+            tasks[i].expiry *= k;
+            if(tasks[i].slot != TASK_NONE) {
+                cuteOS_WheelInsert(i);
+            }
+        }
+    }
+
+#if CUTEOS_CFG_TIMERS
+    /*!< The order of the expiries does not change */
+    for(i = 0; i < CUTEOS_CFG_TIMERS; ++i) {
+        if(cuteOS_timers[i].state & (TIMER_ARMED | TIMER_RELOAD)) {
+            cuteOS_timers[i].expiry *= k;
+            cuteOS_timers[i].ticks = cuteOS_TimerTicks(cuteOS_timers[i].duration);
+        }
+    }
+    TIMER_DUE_UPDATE();
+#endif
+    HAL_INT_ENABLE();
+}
+
+/**********************************************************************
+ * @brief   Schedule one task after \ref cuteOS_Start(), from its period
+ *          and offset.
+ * @details The task is unlinked, its ticks and phase are set (an automatic
+ *          offset is chosen by \ref cuteOS_Balance() among the placed
+ *          tasks), then it is linked at its first release after the
+ *          current tick: the origin of the offsets plus its phase plus
+ *          whole periods, so it is on the same grid as if it had been
+ *          created before the start. An event task waits for its timeout
+ *          from the current tick. A suspended task is linked by
+ *          \ref cuteOS_TaskResume().
+ *********************************************************************/
+static void cuteOS_TaskSchedule(const u8_t index) {
+    u32_t late;
+
+    HAL_INT_DISABLE();
+    cuteOS_WheelUnlink(index);
+    HAL_INT_ENABLE();
+
+    tasks[index].ticks = tasks[index].period / cuteOS_tick_time;
+    if(CUTEOS_OFFSET_AUTO == tasks[index].offset) {
+#if CUTEOS_CFG_BALANCE
+        tasks[index].phase = PHASE_UNPLACED;
+        cuteOS_Balance();
+#else
+        tasks[index].phase = 0;
+#endif
+    } else {
+        tasks[index].phase = tasks[index].offset / cuteOS_tick_time;
+    }
+
+    if(tasks[index].ticks != 0) {      /*!< Else: an event task without timeout */
+        HAL_INT_DISABLE();
+#if CUTEOS_CFG_EVENTS
+        if(tasks[index].event_mask != 0) {
+            tasks[index].expiry = cuteOS_tick_count + tasks[index].ticks;
+        } else
+#endif
+        {
+            tasks[index].expiry = cuteOS_origin + tasks[index].phase;
+            late = cuteOS_tick_count - tasks[index].expiry;
+            if((s32_t)late >= 0) {
+                tasks[index].expiry += ((late / tasks[index].ticks) + 1) * tasks[index].ticks;
+            }
+        }
+        if(FALSE == tasks[index].suspended) {
+            cuteOS_WheelInsert(index);
+        }
+        HAL_INT_ENABLE();
+    }
+}
+
+#if CUTEOS_CFG_ADMISSION
+/*!< TRUE if a task is checked by cuteOS_Admit(): a periodic task with a budget */
+#if CUTEOS_CFG_EVENTS
+#define ADMIT_CHECKED(I)    ( (tasks[I].callback != NULL) && (tasks[I].wcet_us != 0) && (0 == tasks[I].event_mask) )
+#else
+#define ADMIT_CHECKED(I)    ( (tasks[I].callback != NULL) && (tasks[I].wcet_us != 0) )
+#endif
+
+/**********************************************************************
+ * @brief   Check that the task set still fits in the CPU time, with the
+ *          task \c index at the period \c PERIOD.
+ * @details Called when a task is created (allocated, not scheduled yet)
+ *          or before its period changes. The tick time is the one the
+ *          task set will run with: \ref cuteOS_GCD() before
+ *          \ref cuteOS_Start(), the one \ref cuteOS_TickFit() will switch
+ *          to after it. The periodic tasks with a budget are checked:
+ *          - Utilization: the sum of budget / period, each rounded up to a
+ *            millionth (a thousandth per us of the time unit, see
+ *            \ref CUTEOS_CFG_TIME_UNIT_US).
+ *          - Worst tick: for each task, its budget plus the budgets of the
+ *            tasks it can meet, against the tick time. Two tasks meet when
+ *            their offsets are congruent modulo the GCD of their periods.
+ *            The offset of a task is unknown when it is automatic and not
+ *            chosen yet by \ref cuteOS_Balance(): it meets all the others.
+ * @param[in] index: The new or changed task.
+ * @param[in] PERIOD: Its new period.
+ * @return  \c ERROR_t: \ref ERROR_BUSY if the task set would be
+ *          overloaded.
+ *********************************************************************/
+static ERROR_t cuteOS_Admit(const u8_t index, const u32_t PERIOD) {
+    ERROR_t error = ERROR_NO;
+    const u32_t OLD_PERIOD = tasks[index].period;
+    u32_t tick_us;
+    u32_t load;
+    u32_t offset;
+    u32_t distance;
+    u8_t i;
+    u8_t j;
+
+    /*!< Set the new period for the check only: the ISR does not read it, the ticks are not changed */
+    tasks[index].period = PERIOD;
+
+    if(TRUE == cuteOS_started) {
+        tick_us = cuteOS_GCD2(cuteOS_tick_time, PERIOD);
+        if(tasks[index].offset != CUTEOS_OFFSET_AUTO) {
+            tick_us = cuteOS_GCD2(tick_us, tasks[index].offset);
+        }
+    } else {
+        (void)cuteOS_GCD(&tick_us);
+    }
+    if(tick_us <= 1) {
+        tick_us = 1;        /*!< Like cuteOS_SetTickTime() */
+    }
+    tick_us *= CUTEOS_CFG_TIME_UNIT_US;
+
+    /*!< Utilization, in 1 / (1000 * time unit in us): millionths with the default ms unit */
+    load = 0;
+    for(i = 0; i < MAX_TASKS_NUM; ++i) {
+        if(ADMIT_CHECKED(i)) {
+            load += ((u32_t)tasks[i].wcet_us * 1000) / tasks[i].period;
+            if( (((u32_t)tasks[i].wcet_us * 1000) % tasks[i].period) != 0 ) {
+                ++load;
+            }
+        }
+    }
+    if(load > (1000UL * CUTEOS_CFG_TIME_UNIT_US)) {
+        error |= ERROR_BUSY;
+    }
+
+    /*!< Worst tick of each task */
+    for(i = 0; (i < MAX_TASKS_NUM) && (ERROR_NO == error); ++i) {
+        if(!ADMIT_CHECKED(i)) {
+            continue;
+        }
+        load = tasks[i].wcet_us;
+        offset = cuteOS_AdmitOffset(i, index);
+        for(j = 0; j < MAX_TASKS_NUM; ++j) {
+            if( (j == i) || !ADMIT_CHECKED(j) ) {
+                continue;
+            }
+            distance = cuteOS_AdmitOffset(j, index);
+            if( (CUTEOS_OFFSET_AUTO == offset) || (CUTEOS_OFFSET_AUTO == distance) ) {
+                load += tasks[j].wcet_us;
+            } else {
+                distance = (offset > distance) ? (offset - distance) : (distance - offset);
+                if( 0 == (distance % cuteOS_GCD2(tasks[i].period, tasks[j].period)) ) {
+                    load += tasks[j].wcet_us;
+                }
+            }
+        }
+        if(load > tick_us) {
+            error |= ERROR_BUSY;
+        }
+    }
+
+    tasks[index].period = OLD_PERIOD;
+
+    return error;
+}
+
+/**********************************************************************
+ * @brief   Release offset of a task in time units for \ref cuteOS_Admit().
+ * @param[in] i: The task.
+ * @param[in] index: The task being checked, its offset is chosen again
+ *            when it is automatic.
+ * @return  \c u32_t: The offset, or \ref CUTEOS_OFFSET_AUTO if it is not
+ *          known yet.
+ *********************************************************************/
+static u32_t cuteOS_AdmitOffset(const u8_t i, const u8_t index) {
+    u32_t offset = tasks[i].offset;
+
+    if(CUTEOS_OFFSET_AUTO == offset) {
+#if CUTEOS_CFG_BALANCE
+        if( (TRUE == cuteOS_started) && (i != index) && (tasks[i].phase != PHASE_UNPLACED) ) {
+            offset = tasks[i].phase * cuteOS_tick_time;     /*!< Chosen by cuteOS_Balance() */
+        }
+#else
+        offset = 0;             /*!< Without balancing, an automatic offset is 0 */
+        (void)index;
+#endif
+    }
+
+    return offset;
+}
+#endif
+#endif
+
+#if !CUTEOS_CFG_STATIC || CUTEOS_CFG_BALANCE
+/**********************************************************************
+ * @brief   Greatest common divisor of two numbers (Euclid), gcd(0, y) = y.
+ *********************************************************************/
+static u32_t cuteOS_GCD2(u32_t x, u32_t y) {
+    u32_t remainder;
+
+    while(y != 0) {
+        remainder = x % y;
+        x = y;
+        y = remainder;
+    }
+
+    return x;
+}
+#endif
+
+#if CUTEOS_CFG_BALANCE
+/**********************************************************************
+ * @brief   Choose the offsets of the tasks created with \ref CUTEOS_OFFSET_AUTO.
+ * @details Two tasks of periods P1 and P2 (in ticks) and offsets O1 and O2
+ *          are released in the same tick from time to time if and only if
+ *          O1 = O2 (mod gcd(P1, P2)). The tasks are placed one by one,
+ *          shortest period first, at the offset that is shared with the
+ *          fewest tasks already placed (the tasks with a fixed offset are
+ *          placed from the start). The first \ref BALANCE_SPAN offsets of
+ *          the period are tried, the smallest one wins a tie.
+ *          Called by \ref cuteOS_UpdateTicks(), before the tasks are linked
+ *          in the timing wheel.
+ *********************************************************************/
+static void cuteOS_Balance(void) {
+    u32_t gcd;
+    u8_t span;
+    u8_t best;
+    u8_t offset;
+    u8_t i;
+
+    while(1) {
+        /*!< The next task to place: the unplaced task of shortest period */
+        best = TASK_NONE;
+        for(i = 0; i < MAX_TASKS_NUM; ++i) {
+            if( (tasks[i].callback != NULL) && (PHASE_UNPLACED == tasks[i].phase) &&
+                ( (TASK_NONE == best) || (tasks[i].ticks < tasks[best].ticks) ) ) {
+                best = i;
+            }
+        }
+        if(TASK_NONE == best) {
+            break;
+        }
+
+        span = (tasks[best].ticks < BALANCE_SPAN) ? (u8_t)tasks[best].ticks : BALANCE_SPAN;
+        for(offset = 0; offset < span; ++offset) {
+            cuteOS_balance_load[offset] = 0;
+        }
+
+        /*!< Count the placed tasks released together with each offset */
+        for(i = 0; i < MAX_TASKS_NUM; ++i) {
+            if( (i == best) || (NULL == tasks[i].callback) || (PHASE_UNPLACED == tasks[i].phase) ) {
+                continue;
+            }
+            gcd = cuteOS_GCD2(tasks[best].ticks, tasks[i].ticks);
+            for(offset = 0; offset < span; ++offset) {
+                if( (offset % gcd) == (tasks[i].phase % gcd) ) {
+                    ++cuteOS_balance_load[offset];
+                }
+            }
+        }
+
+        tasks[best].phase = 0;
+        for(offset = 1; offset < span; ++offset) {
+            if(cuteOS_balance_load[offset] < cuteOS_balance_load[tasks[best].phase]) {
+                tasks[best].phase = offset;
+            }
+        }
+    }
+}
+#endif
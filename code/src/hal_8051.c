@@ -0,0 +1,113 @@
+/***************************************************************************
+ * @file    hal_8051.c
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   8051 backend of the Hardware Abstraction Layer. See \ref hal.h.
+ * @version 1.0.0
+ * @date    2022-04-20
+ * @copyright Copyright (c) 2022
+ ***************************************************************************/
+#include "STD_TYPES.h"
+#include "main.h"
+#include "hal.h"
+
+#if defined(HAL_8051)
+
+/*--------------------------------------------------------------------*/
+/*                          PUBLIC FUNCTIONS                          */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @details Configure Timer 2:
+ *          - Timer mode
+ *          - 16-bit auto-reload mode
+ *          - Interrupt enable
+ *********************************************************************/
+void HAL_TimerStart(const u16_t reload, void (* const isr)(void)) {
+    (void)isr;      /*!< The ISR is bound by its interrupt vector */
+
+    TR2 = 0;                                /*!< Disable Timer 2 */
+
+    /******************************************************************
+     * Enable Timer 2 (16-bit timer) and configure it as a timer and automatically
+     * reloaded its value at overflow
+     ******************************************************************/
+    T2CON = 0x04;   /*!< Load Timer 2 control register  */
+
+    RCAP2H = TH2 = (u8_t)(reload / 256);    /*!< Load T2 and reload capt. reg. high bytes   */
+    RCAP2L = TL2 = (u8_t)(reload % 256);    /*!< Load T2 and reload capt. reg. low bytes    */
+
+    ET2 = 1;                                /*!< Enable Timer 2 interrupt    */
+    TR2 = 1;                                /*!< Start Timer 2    */
+    EA = 1;                                 /*!< Globally enable interrupts   */
+}
+
+void HAL_TimerStop(void) {
+    TR2 = 0;
+}
+
+u16_t HAL_TimerRead(void) HAL_REENTRANT {
+    u8_t high;
+    u8_t low;
+
+    do {
+        high = TH2;
+        low = TL2;
+    } while(high != TH2);   /*!< TL2 overflowed into TH2 between the reads */
+
+    return (u16_t)( ((u16_t)high << 8) | low );
+}
+
+void HAL_ExtIntEnable(const u8_t number, void (* const isr)(void)) {
+    (void)isr;      /*!< The ISR is bound by its interrupt vector */
+
+    if(0 == number) {
+        IT0 = 1;    /*!< Falling edge */
+        EX0 = 1;
+    } else if(1 == number) {
+        IT1 = 1;
+        EX1 = 1;
+    }
+}
+
+/**********************************************************************
+ * @details With \ref HAL_CFG_SLEEP_CLOCK, the application clock is started
+ *          before EA is set, so nothing runs between EA = 1 and the
+ *          power-down instruction.
+ *********************************************************************/
+u32_t HAL_PowerDown(void) {
+#if HAL_CFG_SLEEP_CLOCK
+    HAL_SleepClockStart();
+#endif
+    EA = 1;
+    PCON |= 0x02;   /*!< Runs before any interrupt after EA = 1, the CPU stops here */
+
+#if HAL_CFG_SLEEP_CLOCK
+    return HAL_SleepClockRead();
+#else
+    return 0;       /*!< No clock runs in power-down: the time slept is unknown */
+#endif
+}
+
+/**********************************************************************
+ * @details The ports are separate SFRs, so the port number selects one
+ *          \ref HAL_PORT_WRITE per port.
+ *********************************************************************/
+void HAL_PortWrite(const u8_t port, const u8_t mask, const u8_t value) {
+    switch(port) {
+        case 0:
+            HAL_PORT_WRITE(0, mask, value);
+            break;
+        case 1:
+            HAL_PORT_WRITE(1, mask, value);
+            break;
+        case 2:
+            HAL_PORT_WRITE(2, mask, value);
+            break;
+        case 3:
+            HAL_PORT_WRITE(3, mask, value);
+            break;
+        default:
+            break;
+    }
+}
+
+#endif  /* HAL_8051 */
@@ -0,0 +1,360 @@
+/***************************************************************************
+ * @file    hal_posix.c
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   POSIX (Linux host) backend of the Hardware Abstraction Layer.
+ *          See \ref hal.h.
+ * @details The 8051 peripherals are simulated as follows:
+ *          - Timer 2: a POSIX interval timer (CLOCK_MONOTONIC) delivers
+ *            \c SIGALRM every (65536 - reload) timer increments. The signal
+ *            handler calls the scheduler ISR, so the ISR interrupts the
+ *            application exactly like the Timer 2 overflow does.
+ *          - EA: blocking/unblocking \c SIGALRM, \c SIGUSR1 and \c SIGUSR2.
+ *          - ET2: a flag checked by the signal handler. An overflow while
+ *            the flag is cleared stays pending, like TF2, and the ISR runs
+ *            when the flag is set again.
+ *          - INT0 and INT1: \c SIGUSR1 and \c SIGUSR2 (e.g. from
+ *            <tt>kill -USR1 PID</tt>), they call the ISR given to
+ *            \ref HAL_ExtIntEnable().
+ *          - Idle mode: \c pause() until the next signal.
+ *          - Power-down mode: the POSIX timer is stopped, the process waits
+ *            for \c SIGUSR1 or \c SIGUSR2, then the timer goes on from the
+ *            time it had left. The time slept is measured and returned.
+ *          - Ports: the array \ref HAL_ports holds the port latches.
+ *
+ *          Options:
+ *          - Environment variable \c CUTEOS_RUN_TICKS=N : Exit after N
+ *            timer overflows (default: run forever). Useful for profiling
+ *            runs on CI.
+ *          - Compiler define \c HAL_POSIX_GPIO_LOG : Print every port
+ *            change to stdout.
+ * @version 1.0.0
+ * @date    2022-04-20
+ * @copyright Copyright (c) 2022
+ ***************************************************************************/
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "STD_TYPES.h"
+#include "main.h"
+#include "hal.h"
+
+#if defined(HAL_POSIX)
+
+/*--------------------------------------------------------------------*/
+/*                          PUBLIC DATA                               */
+/*--------------------------------------------------------------------*/
+volatile u8_t HAL_ports[HAL_PORTS_NUM] = {0xFF, 0xFF, 0xFF, 0xFF}; /*!< Port latches are high after reset */
+
+
+/*--------------------------------------------------------------------*/
+/*                          PRIVATE DATA                              */
+/*--------------------------------------------------------------------*/
+static void (*HAL_timer_isr)(void) = NULL;      /*!< Scheduler ISR */
+static timer_t HAL_timer_id;                    /*!< POSIX timer standing in for Timer 2 */
+static BOOL_t HAL_timer_created = FALSE;
+static volatile sig_atomic_t HAL_timer_overflows = 0;   /*!< Number of Timer 2 overflows */
+static long HAL_run_ticks = 0;                  /*!< Exit after this number of overflows, 0: never */
+static volatile sig_atomic_t HAL_timer_int_enabled = 1; /*!< Simulated ET2 */
+static volatile sig_atomic_t HAL_timer_int_pending = 0; /*!< Simulated TF2, set while ET2 is cleared */
+static void (* volatile HAL_ext_isr[2])(void) = {NULL, NULL};  /*!< ISRs of INT0 and INT1, NULL: disabled */
+static volatile sig_atomic_t HAL_ext_woken = 0; /*!< An enabled external interrupt happened */
+
+
+/*--------------------------------------------------------------------*/
+/*                  PRIVATE FUNCTIONS DEFINITIONS                     */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @brief   Convert a Timer 2 reload value to the period it gives.
+ *********************************************************************/
+static void HAL_PosixReloadToTime(const u16_t reload, struct timespec * const period) {
+    const unsigned long long period_ns = ( (65536ULL - reload) * OSC_PER_INST * 1000000000ULL ) / OSC_FREQ;
+
+    period->tv_sec = (time_t)(period_ns / 1000000000ULL);
+    period->tv_nsec = (long)(period_ns % 1000000000ULL);
+}
+
+/**********************************************************************
+ * @brief   Fill \c set with the signals masked by EA.
+ *********************************************************************/
+static void HAL_PosixIntSet(sigset_t * const set) {
+    sigemptyset(set);
+    sigaddset(set, SIGALRM);
+    sigaddset(set, SIGUSR1);
+    sigaddset(set, SIGUSR2);
+}
+
+/**********************************************************************
+ * @brief   SIGUSR1 and SIGUSR2 handler, the INT0 and INT1 interrupt vectors.
+ *********************************************************************/
+static void HAL_PosixExtHandler(int signal_number) {
+    void (* const isr)(void) = HAL_ext_isr[(SIGUSR1 == signal_number) ? 0 : 1];
+
+    if(isr != NULL) {
+        HAL_ext_woken = 1;
+        isr();
+    }
+}
+
+/**********************************************************************
+ * @brief   SIGALRM handler, it plays the role of the Timer 2 interrupt vector.
+ *********************************************************************/
+static void HAL_PosixTimerHandler(int signal_number) {
+    (void)signal_number;
+
+    ++HAL_timer_overflows;
+    if(0 == HAL_timer_int_enabled) {
+        HAL_timer_int_pending = 1;
+    } else if(HAL_timer_isr != NULL) {
+        if(1 == HAL_timer_int_pending) {    /*!< Overflow left pending while EA was cleared */
+            HAL_timer_int_pending = 0;
+            HAL_timer_isr();
+        }
+        HAL_timer_isr();
+    }
+}
+
+
+/*--------------------------------------------------------------------*/
+/*                          PUBLIC FUNCTIONS                          */
+/*--------------------------------------------------------------------*/
+/**********************************************************************
+ * @details The period of the POSIX timer is the period Timer 2 would have:
+ *          (65536 - reload) * OSC_PER_INST / OSC_FREQ seconds.
+ *********************************************************************/
+void HAL_TimerStart(const u16_t reload, void (* const isr)(void)) {
+    struct sigaction action;
+    struct sigevent event;
+    struct itimerspec spec;
+
+    HAL_TimerStop();
+    HAL_timer_isr = isr;
+
+    if(FALSE == HAL_timer_created) {
+        if(getenv("CUTEOS_RUN_TICKS") != NULL) {
+            HAL_run_ticks = atol(getenv("CUTEOS_RUN_TICKS"));
+        }
+
+        action.sa_handler = HAL_PosixTimerHandler;
+        action.sa_flags = SA_RESTART;
+        HAL_PosixIntSet(&action.sa_mask);   /*!< An ISR is not interrupted by the others */
+        sigaction(SIGALRM, &action, NULL);
+
+        event.sigev_notify = SIGEV_SIGNAL;
+        event.sigev_signo = SIGALRM;
+        event.sigev_value.sival_ptr = NULL;
+        if(0 != timer_create(CLOCK_MONOTONIC, &event, &HAL_timer_id)) {
+            perror("timer_create");
+            exit(EXIT_FAILURE);
+        }
+        HAL_timer_created = TRUE;
+    }
+
+    HAL_PosixReloadToTime(reload, &spec.it_value);
+    spec.it_interval = spec.it_value;
+    timer_settime(HAL_timer_id, 0, &spec, NULL);
+
+    HAL_timer_int_enabled = 1;
+    HAL_timer_int_pending = 0;
+    HAL_PosixIntEnable();
+}
+
+void HAL_TimerStop(void) {
+    struct itimerspec spec = {{0, 0}, {0, 0}};
+
+    if(TRUE == HAL_timer_created) {
+        timer_settime(HAL_timer_id, 0, &spec, NULL);
+    }
+}
+
+/**********************************************************************
+ * @details Like RCAP2H:RCAP2L, only the interval changes: the time left
+ *          until the next expiry is kept.
+ *********************************************************************/
+void HAL_PosixTimerSetReload(const u16_t reload) {
+    struct itimerspec spec;
+
+    timer_gettime(HAL_timer_id, &spec);
+    HAL_PosixReloadToTime(reload, &spec.it_interval);
+    timer_settime(HAL_timer_id, 0, &spec, NULL);
+}
+
+/**********************************************************************
+ * @details The count is computed from the time left until the next
+ *          expiry of the POSIX timer.
+ *********************************************************************/
+u16_t HAL_TimerRead(void) HAL_REENTRANT {
+    struct itimerspec spec;
+    unsigned long long left;
+
+    timer_gettime(HAL_timer_id, &spec);
+    left = ( ((unsigned long long)spec.it_value.tv_sec * 1000000000ULL + (unsigned long long)spec.it_value.tv_nsec) * OSC_FREQ )
+           / (OSC_PER_INST * 1000000000ULL);
+
+    return (left >= 65536ULL) ? 0 : (u16_t)(65536ULL - left);
+}
+
+/**********************************************************************
+ * @details The signal is pending while the interrupts are disabled.
+ *********************************************************************/
+BOOL_t HAL_PosixTimerOverflowPending(void) {
+    sigset_t set;
+
+    sigpending(&set);
+
+    return ( sigismember(&set, SIGALRM) || (1 == HAL_timer_int_pending) ) ? TRUE : FALSE;
+}
+
+void HAL_PosixIntEnable(void) {
+    sigset_t set;
+
+    HAL_PosixIntSet(&set);
+    sigprocmask(SIG_UNBLOCK, &set, NULL);
+}
+
+void HAL_PosixIntDisable(void) {
+    sigset_t set;
+
+    HAL_PosixIntSet(&set);
+    sigprocmask(SIG_BLOCK, &set, NULL);
+}
+
+/**********************************************************************
+ * @details The signals are blocked together, so SIGALRM tells whether
+ *          the interrupts were enabled. In a handler they are blocked
+ *          (see sa_mask), so the state saved there is "disabled".
+ *********************************************************************/
+u8_t HAL_PosixIntSave(void) {
+    sigset_t set;
+    sigset_t old_set;
+
+    HAL_PosixIntSet(&set);
+    sigprocmask(SIG_BLOCK, &set, &old_set);
+
+    return sigismember(&old_set, SIGALRM) ? 0 : 1;
+}
+
+void HAL_PosixIntRestore(const u8_t state) {
+    if(state != 0) {
+        HAL_PosixIntEnable();
+    }
+}
+
+/**********************************************************************
+ * @details A pending overflow is serviced at once, unless the interrupts
+ *          are globally disabled: then it is left to the signal handler.
+ *********************************************************************/
+void HAL_PosixTimerIntEnable(void) {
+    sigset_t set;
+    sigset_t old_set;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigprocmask(SIG_BLOCK, &set, &old_set);
+
+    HAL_timer_int_enabled = 1;
+    if( (1 == HAL_timer_int_pending) && !sigismember(&old_set, SIGALRM) ) {
+        HAL_timer_int_pending = 0;
+        if(HAL_timer_isr != NULL) {
+            HAL_timer_isr();
+        }
+    }
+
+    sigprocmask(SIG_SETMASK, &old_set, NULL);
+}
+
+void HAL_PosixTimerIntDisable(void) {
+    HAL_timer_int_enabled = 0;
+}
+
+/**********************************************************************
+ * @details Sleep until the next signal, like the 8051 idle mode that
+ *          wakes up on the next interrupt.
+ *********************************************************************/
+void HAL_PosixIdle(void) {
+    pause();
+
+    if( (HAL_run_ticks > 0) && (HAL_timer_overflows >= HAL_run_ticks) ) {
+        exit(EXIT_SUCCESS);
+    }
+}
+
+void HAL_ExtIntEnable(const u8_t number, void (* const isr)(void)) {
+    struct sigaction action;
+
+    if(number > 1) {
+        return;
+    }
+
+    HAL_ext_isr[number] = isr;
+    action.sa_handler = HAL_PosixExtHandler;
+    action.sa_flags = SA_RESTART;
+    HAL_PosixIntSet(&action.sa_mask);
+    sigaction((0 == number) ? SIGUSR1 : SIGUSR2, &action, NULL);
+}
+
+/**********************************************************************
+ * @details The POSIX timer is stopped and restarted with the time it had
+ *          left, like Timer 2 that keeps its count in power-down. The
+ *          signal mask is swapped atomically by \c sigsuspend(), so a
+ *          signal sent after the interrupts were disabled wakes it up.
+ *          Only an external interrupt with an ISR ends the wait.
+ *********************************************************************/
+u32_t HAL_PowerDown(void) {
+    const struct itimerspec stopped = {{0, 0}, {0, 0}};
+    struct itimerspec frozen;
+    struct timespec start;
+    struct timespec end;
+    sigset_t wait_set;
+
+    if(TRUE == HAL_timer_created) {
+        timer_settime(HAL_timer_id, 0, &stopped, &frozen);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    sigprocmask(SIG_BLOCK, NULL, &wait_set);
+    sigdelset(&wait_set, SIGUSR1);
+    sigdelset(&wait_set, SIGUSR2);
+    HAL_ext_woken = 0;
+    while(0 == HAL_ext_woken) {
+        sigsuspend(&wait_set);      /*!< The timer is stopped: only INT0 and INT1 come */
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if(TRUE == HAL_timer_created) {
+        timer_settime(HAL_timer_id, 0, &frozen, NULL);
+    }
+    HAL_PosixIntEnable();
+
+    return (u32_t)( ( ((long long)end.tv_sec - (long long)start.tv_sec) * 1000000000LL
+                      + ((long long)end.tv_nsec - (long long)start.tv_nsec) ) / 1000000LL );
+}
+
+void HAL_PosixPinWrite(const u8_t pin, const STATE_t state) {
+    const u8_t port = HAL_PIN_PORT(pin);
+
+    if(LOW == state) {
+        HAL_ports[port] &= (u8_t)~HAL_PIN_MASK(pin);
+    } else {
+        HAL_ports[port] |= HAL_PIN_MASK(pin);
+    }
+
+#if defined(HAL_POSIX_GPIO_LOG)
+    printf("%6ld P%u = 0x%02X\n", (long)HAL_timer_overflows, (unsigned)port, (unsigned)HAL_ports[port]);
+#endif
+}
+
+void HAL_PortWrite(const u8_t port, const u8_t mask, const u8_t value) {
+    if(port >= HAL_PORTS_NUM) {
+        return;
+    }
+
+    HAL_ports[port] = (u8_t)( (HAL_ports[port] & (u8_t)~mask) | (value & mask) );
+
+#if defined(HAL_POSIX_GPIO_LOG)
+    printf("%6ld P%u = 0x%02X\n", (long)HAL_timer_overflows, (unsigned)port, (unsigned)HAL_ports[port]);
+#endif
+}
+
+#endif  /* HAL_POSIX */
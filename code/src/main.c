@@ -27,49 +27,59 @@
  * 				@code TRAFFIC_Init();	@endcode
  * 				See \ref TRAFFIC_Init() for more details.
  * 			3. Create the tasks.
- *              @code cuteOS_TaskCreate(task1, 1000); // task1 will run every 1 second  @endcode
- *              @code cuteOS_TaskCreate(task2, 2000); // task2 will run every 2 seconds @endcode
+ *              @code cuteOS_TaskCreate(task1, CUTEOS_MS(1000), CUTEOS_PRIO_AUTO, NULL); // task1 will run every 1 second  @endcode
+ *              @code cuteOS_TaskCreate(task2, CUTEOS_MS(2000), CUTEOS_PRIO_AUTO, NULL); // task2 will run every 2 seconds @endcode
  *          4. Start the Cute OS scheduler.
  *              @code cuteOS_Start();   @endcode
  ********************************************************************************/
-#include <reg52.h>
 #include "STD_TYPES.h"
 #include "BIT_MATH.h"
-#include "Main.h"
-#include "Port.h"
+#include "main.h"
+#include "hal.h"
+#include "port.h"
+#include "cuteOS_cfg.h"
 #include "cuteOS.h"
 #include "traffic.h"
+#if CUTEOS_CFG_TRACE && defined(HAL_POSIX)
+#include <stdio.h>
+#include <stdlib.h>
+#endif
 
 /*------------------------------------------------------------------------------*/
 /*	THE FOLLOWING ARE ONLY FOR TESTING THE SIMPLE OS.				  			*/
 /*	DO NOT USE THEM IN YOUR APPLICATION.							  			*/
 /*------------------------------------------------------------------------------*/
-void led1_toggle(void){
-	led1Pin = !led1Pin;
+ERROR_t led1_toggle(void){
+	HAL_PIN_TOGGLE(led1Pin);
+	return ERROR_NO;
 }
 
-void led2_toggle(void){
-	led2Pin = !led2Pin;
+ERROR_t led2_toggle(void){
+	HAL_PIN_TOGGLE(led2Pin);
+	return ERROR_NO;
 }
 
-void led3_toggle(void){
-	led3Pin = !led3Pin;
+ERROR_t led3_toggle(void){
+	HAL_PIN_TOGGLE(led3Pin);
+	return ERROR_NO;
 }
 
-void motor_toggle(void){
-	motorPin = !motorPin;
+ERROR_t motor_toggle(void){
+	HAL_PIN_TOGGLE(motorPin);
+	return ERROR_NO;
 }
 
-void buzzer_toggle(void){
-	buzzerPin = !buzzerPin;
+ERROR_t buzzer_toggle(void){
+	HAL_PIN_TOGGLE(buzzerPin);
+	return ERROR_NO;
 }
 
 void Init_Others(void) {
-	led1Pin = 1;
-	led2Pin = 0;
-	led3Pin = 0;
-	motorPin = 1;
-	buzzerPin = 0;
+	HAL_PIN_WRITE(led1Pin,   HIGH);
+	HAL_PIN_WRITE(led2Pin,   LOW);
+	HAL_PIN_WRITE(led3Pin,   LOW);
+	HAL_PIN_WRITE(motorPin,  HIGH);
+	HAL_PIN_WRITE(buzzerPin, LOW);
 }
 
 
@@ -77,24 +87,53 @@ void Init_Others(void) {
 
 
 
+#if CUTEOS_CFG_TRACE && defined(HAL_POSIX)
+/*------------------------------------------------------------------------------*/
+/*	POSIX ONLY: DUMP THE TRACE AT EXIT TO THE FILE $CUTEOS_TRACE_FILE (trace.mk)	*/
+/*------------------------------------------------------------------------------*/
+static FILE *trace_file = NULL;
+
+static void trace_put(const u8_t BYTE) {
+	fputc(BYTE, trace_file);
+}
+
+static void trace_save(void) {
+	trace_file = fopen(getenv("CUTEOS_TRACE_FILE"), "wb");
+	if(trace_file != NULL) {
+		cuteOS_TraceDump(trace_put);
+		fclose(trace_file);
+	}
+}
+#endif
+
 /*------------------------------------------------------------------------------*/
 /*					APPLICATION MAIN FUNCTION						  			*/
 /*------------------------------------------------------------------------------*/
 void main(void) {
+#if !CUTEOS_CFG_STATIC
+	cuteOS_TASK_HANDLE_t buzzer;	/*!< Handle of the buzzer task */
+#endif
+
 	/* Initialize the system */
 	cuteOS_Init();					/*!< Initialize Cute OS 					*/
-	TRAFFIC_Init();					/*!< Initialize the traffic light system	*/
+	TRAFFIC_Init();					/*!< Initialize the traffic light system, it runs from its own timer */
 	Init_Others();					/*!< Initialize other peripherals			*/
+#if CUTEOS_CFG_TRACE && defined(HAL_POSIX)
+	if(getenv("CUTEOS_TRACE_FILE") != NULL) {
+		atexit(trace_save);
+	}
+#endif
 
+#if !CUTEOS_CFG_STATIC			/*!< Otherwise, the tasks are listed in cuteOS_tasks_cfg.h */
 	/*!< Create the tasks */
-	cuteOS_TaskCreate(TRAFFIC_Update, 1000);	/*!< Create a task to run the traffic light system */
-	cuteOS_TaskCreate(led1_toggle	, 1000);	/*!< Create a task to toggle the first LED */
-	cuteOS_TaskCreate(led2_toggle	, 2000);	/*!< Create a task to toggle the second LED */
-	cuteOS_TaskCreate(led3_toggle	, 4000);	/*!< Create a task to toggle the third LED */
-	cuteOS_TaskCreate(buzzer_toggle	, 2000);	/*!< Create a task to toggle the buzzer */
-	cuteOS_TaskCreate(motor_toggle	, 5000);	/*!< Create a task to toggle the motor */
+	cuteOS_TaskCreate(led1_toggle	, CUTEOS_MS(1000), CUTEOS_PRIO_AUTO, NULL);	/*!< Create a task to toggle the first LED */
+	cuteOS_TaskCreate(led2_toggle	, CUTEOS_MS(2000), CUTEOS_PRIO_AUTO, NULL);	/*!< Create a task to toggle the second LED */
+	cuteOS_TaskCreate(led3_toggle	, CUTEOS_MS(4000), CUTEOS_PRIO_AUTO, NULL);	/*!< Create a task to toggle the third LED */
+	cuteOS_TaskCreate(buzzer_toggle	, CUTEOS_MS(2000), CUTEOS_PRIO_AUTO, &buzzer);	/*!< Create a task to toggle the buzzer */
+	cuteOS_TaskCreate(motor_toggle	, CUTEOS_MS(5000), CUTEOS_PRIO_AUTO, NULL);	/*!< Create a task to toggle the motor */
 	
-	cuteOS_TaskRemove(buzzer_toggle);	/*!< Remove the task to toggle the buzzer */
+	cuteOS_TaskRemove(buzzer);		/*!< Remove the task to toggle the buzzer */
+#endif
 
 	cuteOS_Start();
 }
@@ -6,109 +6,88 @@
  *          from the environment and will perform well by executing a sequence
  *          of pre-determined manoeuvres.
  *          It is a classic example of a Multi-State (Timed) system.
+ *          The sequence is a table of phases in CODE memory (see 
+ *          \ref traffic_cfg.c): each phase holds the pattern of the lamps, 
+ *          its duration and the next phase. So, other sequences (e.g. 
+ *          flashing amber at night) are other tables, swapped by 
+ *          \ref TRAFFIC_SetPhases(), not other code.
+ *
+ *          One controller runs several intersections (\ref TRAFFIC_Intersections),
+ *          each with its own lamps pins, sequence and start offset. Their
+ *          states are kept in arrays indexed by the intersection, and they
+ *          are all updated by the same callback, \ref TRAFFIC_Update().
+ *
+ *          The state machine is not polled: \ref TRAFFIC_Update() runs from
+ *          a one-shot software timer (\ref cuteOS_TimerStart()) armed to the
+ *          nearest end of phase of all the intersections. Each intersection
+ *          keeps the time left in its phase, so the transitions do not
+ *          drift from each other. The lamps of an intersection are written
+ *          together (\ref HAL_PortWrite()), within two instructions.
+ * @note    The durations and the offsets should be multiples of the tick
+ *          time, the timer expires on ticks.
  *          
  * @version 1.0.0
  * @date    2022-03-22
  * @copyright Copyright (c) 2022
  ***************************************************************************/
-#include <reg52.h>
 #include "STD_TYPES.h"
-#include "Main.h"
-#include "Port.h"
+#include "main.h"
+#include "hal.h"
+#include "port.h"
+#include "cuteOS_cfg.h"
+#include "cuteOS.h"
 #include "traffic.h"
 #include "traffic_cfg.h"
 
+#if !CUTEOS_CFG_TIMERS
+#error "The traffic light sequencer needs a software timer (CUTEOS_CFG_TIMERS)"
+#endif
+
 /*--------------------------------------------------------------------*/
 /*                          PRIVATE DATA                              */
 /*--------------------------------------------------------------------*/
-static TRAFFIC_SEQUENCE_t   colorSequence       = RED;  /*!< Initial colorSequence */
-static u16_t                  timeInState = 0;    /*!< Time counter */
+/*!< State of each intersection, indexed by the intersection */
+static const TRAFFIC_PHASE_t HAL_CODE * HAL_XDATA phases[TRAFFIC_INTERSECTIONS];  /*!< Table of the running sequence */
+static u8_t  HAL_XDATA phasesCount[TRAFFIC_INTERSECTIONS];     /*!< Number of phases in the table */
+static u8_t  HAL_XDATA phase[TRAFFIC_INTERSECTIONS];           /*!< Current phase, index in the table */
+static u32_t HAL_XDATA timeLeftMs[TRAFFIC_INTERSECTIONS];      /*!< Time left in the current phase, at the last update */
+
+static u32_t armedMs = 0;       /*!< Duration the timer was armed with at the last update */
 
 
 /*--------------------------------------------------------------------*/
 /*                    PRIVATE FUNCTIONS PROTOTYPES                    */
 /*--------------------------------------------------------------------*/
-/***************************************************************************
- * @brief  Update the traffic light system to the next state.
- * @return ERROR_t: 
- *          - \ref ERROR_NO in case of success, 
- *          - \ref ERROR_YES in case of failure.
- *          - \ref ERROR_TIMEOUT in case of timeout.
- *          Those errors are members of the global enumeration \ref ERROR_t.
- ***************************************************************************/
-static ERROR_t TRAFFIC_Update(void);
-
-/**********************************************************************
- * @brief   Set the color of the traffic light to RED.
- * @note    This function will be called by the function TRAFFIC_Update().
- * @return  ERROR state: 
- *          - \ref ERROR_NO in case of success, 
- *          - \ref ERROR_YES in case of failure.
- *          - \ref ERROR_TIMEOUT in case of timeout.
- *          Those errors are members of the global enumeration \ref ERROR_t.
- **********************************************************************/
-static ERROR_t TRAFFIC_RedSequence(void);
-
 /**********************************************************************
- * @brief   Set the color of the traffic light to RED_AMBER.
- * @note    This function will be called by the function TRAFFIC_Update().
+ * @brief   Check a table of phases.
  * @return  ERROR state: 
  *          - \ref ERROR_NO in case of success, 
- *          - \ref ERROR_YES in case of failure.
- *          - \ref ERROR_TIMEOUT in case of timeout.
+ *          - \ref ERROR_NULL_POINTER if there is no table,
+ *          - \ref ERROR_ILLEGAL_PARAM if a phase has no duration or a next
+ *            phase out of the table.
  *          Those errors are members of the global enumeration \ref ERROR_t.
  **********************************************************************/
-static ERROR_t TRAFFIC_RedAmberSequence(void);
+static ERROR_t TRAFFIC_Check(const TRAFFIC_PHASE_t HAL_CODE * const Copy_phases, const u8_t Copy_count);
 
 /**********************************************************************
- * @brief   Set the color of the traffic light to GREEN.
- * @note    This function will be called by the function TRAFFIC_Update().
- * @return  ERROR state: 
- *          - \ref ERROR_NO in case of success, 
- *          - \ref ERROR_YES in case of failure.
- *          - \ref ERROR_TIMEOUT in case of timeout.
- *          Those errors are members of the global enumeration \ref ERROR_t.
+ * @brief   Write the lamps of the current phase of an intersection to its
+ *          port (\ref HAL_PortWrite()).
+ * @param[in] Copy_id: The intersection.
  **********************************************************************/
-static ERROR_t TRAFFIC_GreenSequence(void);
+static void TRAFFIC_Show(const u8_t Copy_id);
 
 /**********************************************************************
- * @brief   Set the color of the traffic light to AMBER.
- * @note    This function will be called by the function TRAFFIC_Update().
- * @return  ERROR state: 
- *          - \ref ERROR_NO in case of success, 
- *          - \ref ERROR_YES in case of failure.
- *          - \ref ERROR_TIMEOUT in case of timeout.
- *          Those errors are members of the global enumeration \ref ERROR_t.
+ * @brief   Subtract the time elapsed since the last update from the time
+ *          left of all the intersections, and go to the next phase of the
+ *          intersections whose phase ended.
  **********************************************************************/
-static ERROR_t TRAFFIC_AmberSequence(void);
+static void TRAFFIC_Advance(void);
 
 /**********************************************************************
- * @brief   A generic function to set the color of the traffic light.
- * @param[in] redState: The state of the red lamp.
- * @param[in] amberState: The state of the amber lamp.
- * @param[in] greenState: The state of the green lamp.
- * @note The states of the lamps are either \ref HIGH or \ref LOW, member 
- *       of the global enum \ref STATE_t.
- * @param[in] duration: The duration of the current sequence in SECONDS.
- *            It can be either:
- *              - \ref TRAFFIC_DURATION_RED for the RED sequence.
- *              - \ref TRAFFIC_DURATION_RED_AMBER for the RED-AMBER sequence.
- *              - \ref TRAFFIC_DURATION_GREEN for the GREEN sequence.
- *              - \ref TRAFFIC_DURATION_AMBER for the AMBER sequence.
- *              Those durations are members of the global enumeration 
- *              \ref TRAFFIC_DURATION_t.
- * @note This function is called by the functions:
- *          - TRAFFIC_RedSequence()
- *          - TRAFFIC_RedAmberSequence()
- *          - TRAFFIC_GreenSequence()
- *          - TRAFFIC_AmberSequence()
- * @return ERROR state: 
- *          - \ref ERROR_NO in case of success, 
- *          - \ref ERROR_YES in case of failure.
- *          - \ref ERROR_TIMEOUT in case of timeout.
- *          Those errors are members of the global enumeration \ref ERROR_t.
+ * @brief   Arm the one-shot timer to the nearest end of phase.
+ * @return  ERROR state, see \ref cuteOS_TimerStart().
  **********************************************************************/
-static ERROR_t TRAFFIC_GenericSequence(const STATE_t red, const STATE_t amber, const STATE_t green, TRAFFIC_SEQUENCE_DURATION_t duration);
+static ERROR_t TRAFFIC_Arm(void);
 
 
 
@@ -121,15 +100,25 @@ static ERROR_t TRAFFIC_GenericSequence(const STATE_t red, const STATE_t amber, c
 /*--------------------------------------------------------------------*/
 ERROR_t TRAFFIC_Init(void) {
     ERROR_t error = ERROR_NO;
+    u8_t i;
+
+    /*!< Initialize the sequence of each intersection, delayed by its offset */
+    for(i = 0; i < TRAFFIC_INTERSECTIONS; ++i) {
+        error |= TRAFFIC_Check(TRAFFIC_Intersections[i].phases, TRAFFIC_Intersections[i].count);
+        if(ERROR_NO == error) {
+            phases[i] = TRAFFIC_Intersections[i].phases;
+            phasesCount[i] = TRAFFIC_Intersections[i].count;
+            phase[i] = 0;
+            timeLeftMs[i] = (u32_t)phases[i][0].duration_ms + TRAFFIC_Intersections[i].offset_ms;
+            TRAFFIC_Show(i);
+        }
+    }
 
-    /*!< Reset the time counter */
-    timeInState = 0;
-
-    /*!< Initialize the colorSequence */
-    colorSequence = RED;
-    redPin   = HIGH;
-    amberPin = LOW;
-    greenPin = LOW;
+    /*!< Wait for the first end of phase */
+    if(ERROR_NO == error) {
+        armedMs = 0;
+        error |= TRAFFIC_Arm();
+    }
 
     return error;
 }
@@ -137,161 +126,204 @@ ERROR_t TRAFFIC_Init(void) {
 /***************************************************************************
  * @details This function does the following:
  *          * Turning off all the traffic lights.
- *          * Assign the callback function of the OS delay to NULL.
+ *          * Stopping the timer of the phases.
  ***************************************************************************/
 ERROR_t TRAFFIC_DeInit(void) {
     ERROR_t error = ERROR_NO;
+    const TRAFFIC_PINS_t HAL_CODE * pins;
+    u8_t i;
 
-    /*!< Setting traffic light to red */
-    redPin   = LOW;
-    amberPin = LOW;
-    greenPin = LOW;
+    /*!< Turning off all the lamps */
+    for(i = 0; i < TRAFFIC_INTERSECTIONS; ++i) {
+        pins = &TRAFFIC_Intersections[i].pins;
+        HAL_PortWrite(pins->port, pins->red | pins->amber | pins->green, 0);
+    }
     
-    /*!< Setting callback function to NULL */
-    //cuteOS_(NULL);
+    /*!< No more transitions */
+    (void)cuteOS_TimerStop(TRAFFIC_Update);
 
     return error;
 }
 
-ERROR_t TRAFFIC_SetColor(const TRAFFIC_SEQUENCE_t Copy_color) {
+/***************************************************************************
+ * @details The table is checked first: each phase must have a next phase
+ *          in the table and a duration. The other intersections keep
+ *          their timing.
+ ***************************************************************************/
+ERROR_t TRAFFIC_SetPhases(const u8_t Copy_id, const TRAFFIC_PHASE_t HAL_CODE * const Copy_phases, const u8_t Copy_count) {
     ERROR_t error = ERROR_NO;
-    colorSequence = Copy_color;
 
-    error |= TRAFFIC_Update();
+    if(Copy_id >= TRAFFIC_INTERSECTIONS) {
+        error |= ERROR_OUT_OF_RANGE;
+    } else {
+        error |= TRAFFIC_Check(Copy_phases, Copy_count);
+    }
+
+    if(ERROR_NO == error) {
+        TRAFFIC_Advance();
+        phases[Copy_id] = Copy_phases;
+        phasesCount[Copy_id] = Copy_count;
+        phase[Copy_id] = 0;
+        timeLeftMs[Copy_id] = Copy_phases[0].duration_ms;
+        TRAFFIC_Show(Copy_id);
+        error |= TRAFFIC_Arm();
+    }
 
     return error;
 }
 
-ERROR_t TRAFFIC_GetColor(TRAFFIC_SEQUENCE_t * const Copy_color) {
+/***************************************************************************
+ * @details The phase is shown for its whole duration, from now. The other
+ *          intersections keep their timing.
+ ***************************************************************************/
+ERROR_t TRAFFIC_SetColor(const u8_t Copy_id, const TRAFFIC_SEQUENCE_t Copy_color) {
     ERROR_t error = ERROR_NO;
 
-    *Copy_color = colorSequence;
+    if(Copy_id >= TRAFFIC_INTERSECTIONS) {
+        error |= ERROR_OUT_OF_RANGE;
+    } else if((u8_t)Copy_color >= phasesCount[Copy_id]) {
+        error |= ERROR_ILLEGAL_PARAM;
+    } else {
+        TRAFFIC_Advance();
+        phase[Copy_id] = (u8_t)Copy_color;
+        timeLeftMs[Copy_id] = phases[Copy_id][phase[Copy_id]].duration_ms;
+        TRAFFIC_Show(Copy_id);
+        error |= TRAFFIC_Arm();
+    }
 
     return error;
 }
 
+ERROR_t TRAFFIC_GetColor(const u8_t Copy_id, TRAFFIC_SEQUENCE_t * const Copy_color) {
+    ERROR_t error = ERROR_NO;
 
+    if(NULL == Copy_color) {
+        error |= ERROR_NULL_POINTER;
+    } else if(Copy_id >= TRAFFIC_INTERSECTIONS) {
+        error |= ERROR_OUT_OF_RANGE;
+    } else {
+        *Copy_color = (TRAFFIC_SEQUENCE_t)phase[Copy_id];
+    }
 
+    return error;
+}
 
-
-
-/*--------------------------------------------------------------------*/
-/*                 PRIVATE FUNCTIONS DEFINITIONS                      */
-/*--------------------------------------------------------------------*/
 /***************************************************************************
- * @details This function does the following:
- *          - Setting the traffic light color sequence according to the current 
- *            color sequence.
- *          - Update the OS delay for the current color sequence. 
- *          - Update the color sequence value to the next color sequence.
- *          So, when calling this function again, the color sequence will be changed.
+ * @details This function is the callback of the one-shot timer, armed to
+ *          the nearest end of phase. It moves all the intersections forward
+ *          and arms the timer again.
  ***************************************************************************/
 ERROR_t TRAFFIC_Update(void) {
     ERROR_t error = ERROR_NO;
 
-    /*!< Switch on the current color sequence */
-    switch(colorSequence) {
-        case RED:;
-            error |= TRAFFIC_RedSequence();
-            break;
-        case RED_AMBER:;
-            error |= TRAFFIC_RedAmberSequence();
-            break;
-        case GREEN:;
-            error |= TRAFFIC_GreenSequence();
-            break;
-        case AMBER:;
-            error |= TRAFFIC_AmberSequence();
-            break;
-        default:;
-            error |= ERROR_ILLEGAL_PARAM;   /*!< Illegal color sequence */
-            break;
-    }
+    TRAFFIC_Advance();
+    error |= TRAFFIC_Arm();
 
     return error;
 }
 
-static ERROR_t TRAFFIC_RedSequence(void) {
-    ERROR_t error = ERROR_NO;
-    
-    error |= TRAFFIC_GenericSequence(HIGH, LOW, LOW, TRAFFIC_Configs.red_duration);
 
-    return error;
-}
 
-static ERROR_t TRAFFIC_RedAmberSequence(void) {
-    ERROR_t error = ERROR_NO;
-    
-    error |= TRAFFIC_GenericSequence(HIGH, HIGH, LOW, TRAFFIC_Configs.red_amber_duration);
 
-    return error;
-}
 
-static ERROR_t TRAFFIC_GreenSequence(void) {
+
+/*--------------------------------------------------------------------*/
+/*                 PRIVATE FUNCTIONS DEFINITIONS                      */
+/*--------------------------------------------------------------------*/
+static ERROR_t TRAFFIC_Check(const TRAFFIC_PHASE_t HAL_CODE * const Copy_phases, const u8_t Copy_count) {
     ERROR_t error = ERROR_NO;
-    
-    error |= TRAFFIC_GenericSequence(LOW, LOW, HIGH, TRAFFIC_Configs.green_duration);
+    u8_t i;
+
+    if(NULL == Copy_phases) {
+        error |= ERROR_NULL_POINTER;
+    } else if(0 == Copy_count) {
+        error |= ERROR_ILLEGAL_PARAM;
+    } else {
+        for(i = 0; i < Copy_count; ++i) {
+            if( (Copy_phases[i].next >= Copy_count) || (0 == Copy_phases[i].duration_ms) ) {
+                error |= ERROR_ILLEGAL_PARAM;
+            }
+        }
+    }
 
     return error;
 }
 
-static ERROR_t TRAFFIC_AmberSequence(void) {
-    ERROR_t error = ERROR_NO;
-    
-    error |= TRAFFIC_GenericSequence(LOW, HIGH, LOW, TRAFFIC_Configs.amber_duration);
+/**********************************************************************
+ * @details The lamps of the phase are mapped to the pins of the
+ *          intersection, then the 3 pins are written with one port write.
+ **********************************************************************/
+static void TRAFFIC_Show(const u8_t Copy_id) {
+    const TRAFFIC_PINS_t HAL_CODE * const pins = &TRAFFIC_Intersections[Copy_id].pins;
+    const u8_t lamps = phases[Copy_id][phase[Copy_id]].lamps;
+    u8_t value = 0;
 
-    return error;
+    if(lamps & TRAFFIC_LAMP_RED) {
+        value |= pins->red;
+    }
+    if(lamps & TRAFFIC_LAMP_AMBER) {
+        value |= pins->amber;
+    }
+    if(lamps & TRAFFIC_LAMP_GREEN) {
+        value |= pins->green;
+    }
+
+    HAL_PortWrite(pins->port, pins->red | pins->amber | pins->green, value);
 }
 
 /**********************************************************************
- * @details This function will set the color of the traffic light according to:
- *          - The passed states of each lamp.
- *          - Update the time counter.
- *          - Update the colorSequence according to the time counter
- *            for the current sequence has been completed, and reset the 
- *            time counter.
+ * @details The elapsed time is the duration the timer was armed with,
+ *          minus the time it has left (0 when it expired), both in ms: the
+ *          time left is given in time units. A late update
+ *          may end several phases of an intersection: the time left of the
+ *          new phase is shortened by the delay, so the sequence keeps its
+ *          pace.
  **********************************************************************/
-static ERROR_t TRAFFIC_GenericSequence(const STATE_t redState, const STATE_t amberState, const STATE_t greenState, TRAFFIC_SEQUENCE_DURATION_t duration) {
+static void TRAFFIC_Advance(void) {
+    u32_t elapsed = 0;
+    u32_t over;
+    u32_t remaining;
+    BOOL_t changed;
+    u8_t i;
+
+    if(ERROR_NO == cuteOS_TimerRemaining(TRAFFIC_Update, &remaining)) {
+        remaining /= CUTEOS_MS(1);
+        if(remaining < armedMs) {
+            elapsed = armedMs - remaining;
+        }
+    }
+    armedMs -= elapsed;
+
+    for(i = 0; i < TRAFFIC_INTERSECTIONS; ++i) {
+        over = elapsed;
+        changed = FALSE;
+        while(timeLeftMs[i] <= over) {
+            over -= timeLeftMs[i];
+            phase[i] = phases[i][phase[i]].next;
+            timeLeftMs[i] = phases[i][phase[i]].duration_ms;
+            changed = TRUE;
+        }
+        timeLeftMs[i] -= over;
+
+        if(TRUE == changed) {
+            TRAFFIC_Show(i);
+        }
+    }
+}
+
+static ERROR_t TRAFFIC_Arm(void) {
     ERROR_t error = ERROR_NO;
-    u8_t tickTime = 0;
-
-    /*!< Update the time counter */
-    if(++timeInState >= duration) {
-        timeInState = 0;            /*!< Reset the time counter */
-        switch(colorSequence) {
-            case RED:
-                colorSequence = RED_AMBER;
-                redPin   = HIGH;
-                amberPin = HIGH;
-                greenPin = LOW;
-                break;
-            case RED_AMBER:
-                colorSequence = GREEN;
-                redPin   = LOW;
-                amberPin = LOW;
-                greenPin = HIGH;
-                break;
-            case GREEN:
-                colorSequence = AMBER;
-                redPin   = LOW;
-                amberPin = HIGH;
-                greenPin = LOW;
-                break;
-            case AMBER:
-                colorSequence = RED;
-                redPin   = HIGH;
-                amberPin = LOW;
-                greenPin = LOW;
-                break;
-            default:
-                error |= ERROR_ILLEGAL_PARAM;
-                break;
+    u32_t next = 0xFFFFFFFFUL;
+    u8_t i;
+
+    for(i = 0; i < TRAFFIC_INTERSECTIONS; ++i) {
+        if(timeLeftMs[i] < next) {
+            next = timeLeftMs[i];
         }
-    } else {
-        redPin   = redState;
-        amberPin = amberState;
-        greenPin = greenState;
     }
 
+    armedMs = next;
+    error |= cuteOS_TimerStart(TRAFFIC_Update, CUTEOS_MS(next), CUTEOS_TIMER_ONE_SHOT);
+
     return error;
 }
@@ -7,21 +7,49 @@
  * @copyright Copyright (c) 2022
  ***************************************************************************/
 #include "STD_TYPES.h"
-#include "Main.h"
+#include "main.h"
+#include "hal.h"
+#include "port.h"
 #include "traffic.h"
 #include "traffic_cfg.h"
 
+/*!< Number of milliseconds in a second: the durations are in seconds */
+#define TRAFFIC_MS_PER_SECOND   1000U
+
 
 /*-------------------------------------------------------------------------*/
 /*                YOU CAN CHANGE THE FOLLOWING PARAMETERS				   */
 /*-------------------------------------------------------------------------*/
 /***************************************************************************
- * @brief   Traffic Light System pins connections.
+ * @brief   Day sequence: red, red-amber, green, amber, then red again.
+ * @details The phases are in the order of \ref TRAFFIC_SEQUENCE_t.
+ ***************************************************************************/
+const TRAFFIC_PHASE_t HAL_CODE TRAFFIC_PhasesDay[TRAFFIC_DAY_PHASES] = {
+    /* Lamps                                    Next        Duration (ms) */
+    {TRAFFIC_LAMP_RED,                          RED_AMBER,  TRAFFIC_DURATION_RED       * TRAFFIC_MS_PER_SECOND},
+    {TRAFFIC_LAMP_RED | TRAFFIC_LAMP_AMBER,     GREEN,      TRAFFIC_DURATION_RED_AMBER * TRAFFIC_MS_PER_SECOND},
+    {TRAFFIC_LAMP_GREEN,                        AMBER,      TRAFFIC_DURATION_GREEN     * TRAFFIC_MS_PER_SECOND},
+    {TRAFFIC_LAMP_AMBER,                        RED,        TRAFFIC_DURATION_AMBER     * TRAFFIC_MS_PER_SECOND},
+};
+
+/***************************************************************************
+ * @brief   Night sequence: flashing amber.
  ***************************************************************************/
+const TRAFFIC_PHASE_t HAL_CODE TRAFFIC_PhasesNight[TRAFFIC_NIGHT_PHASES] = {
+    /* Lamps                                    Next        Duration (ms) */
+    {TRAFFIC_LAMP_AMBER,                        1,          TRAFFIC_FLASH_MS},
+    {0,                                         0,          TRAFFIC_FLASH_MS},
+};
 
-TRAFFIC_CONFIGS_t TRAFFIC_Configs = {
-    TRAFFIC_DURATION_RED,
-    TRAFFIC_DURATION_AMBER,
-    TRAFFIC_DURATION_GREEN,
-    TRAFFIC_DURATION_RED_AMBER,
+/***************************************************************************
+ * @brief   The intersections of the corridor.
+ * @details Each intersection starts one travel time (\ref TRAFFIC_WAVE_MS)
+ *          after the previous one, so a car leaving on green reaches the
+ *          next intersection when it turns green (green wave).
+ ***************************************************************************/
+const TRAFFIC_INTERSECTION_t HAL_CODE TRAFFIC_Intersections[TRAFFIC_INTERSECTIONS] = {
+    /* Pins: port,      red,            amber,            green             Phases              Count               Offset (ms) */
+    { {TRAFFIC_0_PORT,  TRAFFIC_0_RED,  TRAFFIC_0_AMBER,  TRAFFIC_0_GREEN}, TRAFFIC_PhasesDay,  TRAFFIC_DAY_PHASES, 0},
+    { {TRAFFIC_1_PORT,  TRAFFIC_1_RED,  TRAFFIC_1_AMBER,  TRAFFIC_1_GREEN}, TRAFFIC_PhasesDay,  TRAFFIC_DAY_PHASES, 1 * TRAFFIC_WAVE_MS},
+    { {TRAFFIC_2_PORT,  TRAFFIC_2_RED,  TRAFFIC_2_AMBER,  TRAFFIC_2_GREEN}, TRAFFIC_PhasesDay,  TRAFFIC_DAY_PHASES, 2 * TRAFFIC_WAVE_MS},
 };
@@ -0,0 +1,80 @@
+###################################################################################
+# Author		: Mahmoud Karam Emara (ma.karam272@gmail.com)
+# Version		: 1.0.0
+# Date 			: 20 April 2022
+# Description	: makefile for the native POSIX (Linux) build of cuteOS:
+#					<make -f posix.mk all>
+#					* Build the kernel, the HAL POSIX backend and the application
+#					  in the build/posix directory
+#					<make -f posix.mk run TICKS=200>
+#					* Run the application for 200 scheduler ticks, printing
+#					  every port change
+###################################################################################
+
+#---------------------------------------------------------------------------------#
+# TOOLS: ----CHANGE THESE AS NEEDED----											  #
+#---------------------------------------------------------------------------------#
+CC		= gcc
+CFLAGS	= -std=c99 -D_POSIX_C_SOURCE=200809L -O2 -g -Wall -Wno-main
+LDLIBS	= -lrt
+RM		= rm -rf
+
+
+
+#---------------------------------------------------------------------------------#
+# TARGET FILES & DIRECTORIES: ----CHANGE THESE AS NEEDED----					  #
+#---------------------------------------------------------------------------------#
+# SRC_DIR: Directory of the source files
+SRC_DIR		= code/src
+# INC_DIR: Directory of the header files
+INC_DIR		= code/include
+# BUILD_DIR: Directory where the generated files will be placed
+BUILD_DIR	= build/posix
+# TARGET: Name of the generated executable
+TARGET		= ${BUILD_DIR}/cuteOS
+
+# SRCS: All sources of the 8051 project except the 8051 HAL backend
+SRCS	= ${SRC_DIR}/cuteOS.c 		\
+		  ${SRC_DIR}/hal_posix.c 	\
+		  ${SRC_DIR}/main.c 		\
+		  ${SRC_DIR}/traffic.c 		\
+		  ${SRC_DIR}/traffic_cfg.c
+
+# DEFINES: Kernel configuration options (see code/include/cuteOS_cfg.h)
+DEFINES	=
+
+# TICKS: Number of Timer 2 overflows before the "run" target exits
+TICKS	= 200
+
+
+
+#---------------------------------------------------------------------------------#
+# GENERATION OF FILES: ----DO NOT CHANGE ANYTHING BELOW THIS LINE----			  #
+#---------------------------------------------------------------------------------#
+OBJS	= $(patsubst ${SRC_DIR}/%.c, ${BUILD_DIR}/%.o, ${SRCS})
+
+# all : build the executable
+all	: ${TARGET}
+
+${TARGET} : ${OBJS}
+	${CC} ${CFLAGS} -o $@ $^ ${LDLIBS}
+
+${BUILD_DIR}/%.o : ${SRC_DIR}/%.c
+	@mkdir -p ${BUILD_DIR}
+	${CC} ${CFLAGS} ${DEFINES} -I${INC_DIR} -MMD -c -o $@ $<
+
+# Rebuild the objects when the headers they include change
+-include ${OBJS:.o=.d}
+
+# run : build a logging executable and run it for ${TICKS} ticks
+run :
+	@${MAKE} -f posix.mk BUILD_DIR=${BUILD_DIR}/run CFLAGS="${CFLAGS} -DHAL_POSIX_GPIO_LOG"
+	@CUTEOS_RUN_TICKS=${TICKS} ${BUILD_DIR}/run/cuteOS
+
+# clean : remove all generated files
+clean :
+	@-${RM} ${BUILD_DIR}
+
+# Phony targets: targets that are not really files, but are used to
+# control the build process.
+.PHONY	: clean all run
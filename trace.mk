@@ -0,0 +1,63 @@
+###################################################################################
+# Author		: Mahmoud Karam Emara (ma.karam272@gmail.com)
+# Version		: 1.0.0
+# Date 			: 16 May 2022
+# Description	: makefile of the trace tools (see trace/trace2json.c):
+#					<make -f trace.mk all>
+#					* Build the host converter build/trace/trace2json, it
+#					  converts a dump of cuteOS_TraceDump() to a Chrome trace
+#					<make -f trace.mk posix TICKS=200>
+#					* Run the application natively with the trace enabled for
+#					  200 ticks, dump the trace at exit and convert it to
+#					  build/trace/trace.json (open it in https://ui.perfetto.dev)
+###################################################################################
+
+#---------------------------------------------------------------------------------#
+# TOOLS: ----CHANGE THESE AS NEEDED----											  #
+#---------------------------------------------------------------------------------#
+CC		= gcc
+CFLAGS	= -std=c99 -D_POSIX_C_SOURCE=200809L -O2 -Wall
+RM		= rm -rf
+
+
+
+#---------------------------------------------------------------------------------#
+# TARGET FILES & DIRECTORIES: ----CHANGE THESE AS NEEDED----					  #
+#---------------------------------------------------------------------------------#
+# TRACE_DIR: Directory of the trace tools sources
+TRACE_DIR	= trace
+# BUILD_DIR: Directory where the generated files will be placed
+BUILD_DIR	= build/trace
+# TICKS: Number of Timer 2 overflows traced by the "posix" target
+TICKS		= 200
+# DEFINES: Kernel configuration of the traced application (see code/include/cuteOS_cfg.h)
+DEFINES		= -DCUTEOS_CFG_TRACE=1
+
+
+
+#---------------------------------------------------------------------------------#
+# GENERATION OF FILES: ----DO NOT CHANGE ANYTHING BELOW THIS LINE----			  #
+#---------------------------------------------------------------------------------#
+CONVERTER	= ${BUILD_DIR}/trace2json
+
+# all : build the converter
+all	: ${CONVERTER}
+
+${CONVERTER} : ${TRACE_DIR}/trace2json.c
+	@mkdir -p ${BUILD_DIR}
+	${CC} ${CFLAGS} -o $@ $<
+
+# posix : trace the POSIX build of the application and convert the dump
+posix : ${CONVERTER} FORCE
+	@${MAKE} -f posix.mk BUILD_DIR=${BUILD_DIR}/app DEFINES="${DEFINES}"
+	@CUTEOS_RUN_TICKS=${TICKS} CUTEOS_TRACE_FILE=${BUILD_DIR}/trace.bin ${BUILD_DIR}/app/cuteOS
+	${CONVERTER} ${BUILD_DIR}/trace.bin > ${BUILD_DIR}/trace.json
+	@echo "Open ${BUILD_DIR}/trace.json in https://ui.perfetto.dev or chrome://tracing"
+
+# clean : remove all generated files
+clean :
+	@-${RM} ${BUILD_DIR}
+
+# Phony targets: targets that are not really files, but are used to
+# control the build process.
+.PHONY	: clean all posix FORCE
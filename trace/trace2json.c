@@ -0,0 +1,183 @@
+/********************************************************************************
+ * @file    trace2json.c
+ * @author  Mahmoud Karam (ma.karam272@gmail.com)
+ * @brief   Host tool: convert a cuteOS trace dump to the Chrome trace format.
+ * @details Reads the bytes sent by \ref cuteOS_TraceDump() (from a file, or
+ * 			from the standard input) and writes a JSON trace that opens in
+ * 			chrome://tracing or https://ui.perfetto.dev:
+ * 			- The tasks and the timer callbacks are slices ("task 3",
+ * 			  "timer 0") on the "tasks" track.
+ * 			- The Timer 2 ticks are instant events on the "isr" track, with
+ * 			  the number of ticks they covered.
+ * 			- The task creations, removals and overruns are instant events
+ * 			  on the "tasks" track.
+ *
+ * 			The 16-bit event times are unwrapped into a 64-bit time line,
+ * 			assuming less than 65536 Timer 2 increments between two
+ * 			events (the ISR records a tick at every Timer 2 period), then
+ * 			converted to microseconds with the increments per ms of the
+ * 			header. The time line starts at the oldest event of the dump.
+ *
+ * 			Usage: trace2json [DUMP] > trace.json
+ * @note    A host program, not built for the 8051. See trace.mk.
+ * @version 1.0.0
+ * @date    2022-05-16
+ * @copyright Copyright (c) 2022
+ ********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/*------------------------------------------------------------------------------*/
+/*	TRACE FORMAT, SEE cuteOS_TraceDump() AND CUTEOS_TRACE_TICK IN cuteOS.h		*/
+/*------------------------------------------------------------------------------*/
+#define TRACE_VERSION		1
+#define TRACE_HEADER_SIZE	10
+#define TRACE_EVENT_SIZE	4
+
+#define TRACE_TICK			0x01
+#define TRACE_TASK_START	0x02
+#define TRACE_TASK_END		0x03
+#define TRACE_TASK_CREATE	0x04
+#define TRACE_TASK_REMOVE	0x05
+#define TRACE_OVERRUN		0x06
+#define TRACE_TIMER_START	0x07
+#define TRACE_TIMER_END		0x08
+
+#define TID_ISR				1	/*!< Track of the Timer 2 ISR */
+#define TID_TASKS			2	/*!< Track of the tasks and the timer callbacks */
+
+/*------------------------------------------------------------------------------*/
+/*	PRIVATE FUNCTIONS													  		*/
+/*------------------------------------------------------------------------------*/
+static unsigned read_u16(const unsigned char * const BYTES) {
+	return (unsigned)BYTES[0] | ((unsigned)BYTES[1] << 8);
+}
+
+/**
+ * @brief	Write one event, separated from the previous one by a comma.
+ */
+static void write_event(const char * const NAME, const char PHASE, const int TID,
+						const double TS_US, const char * const ARGS, int * const ptr_first) {
+	printf("%s\n  {\"name\": \"%s\", \"ph\": \"%c\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f",
+		   (*ptr_first) ? "" : ",", NAME, PHASE, TID, TS_US);
+	if('i' == PHASE) {
+		printf(", \"s\": \"t\"");
+	}
+	if(ARGS != NULL) {
+		printf(", \"args\": {%s}", ARGS);
+	}
+	printf("}");
+	*ptr_first = 0;
+}
+
+/*------------------------------------------------------------------------------*/
+/*	MAIN FUNCTION														  		*/
+/*------------------------------------------------------------------------------*/
+int main(int argc, char *argv[]) {
+	FILE *in = stdin;
+	unsigned char header[TRACE_HEADER_SIZE];
+	unsigned char event[TRACE_EVENT_SIZE];
+	unsigned inc_per_ms;
+	unsigned count;
+	unsigned lost;
+	unsigned i;
+	unsigned stamp;
+	unsigned last_stamp = 0;
+	uint64_t time = 0;
+	double ts_us;
+	char name[32];
+	char args[48];
+	int first = 1;
+	int open_slice = -1;	/*!< Type of the slice started and not ended yet, -1: none */
+
+	if(argc > 2) {
+		fprintf(stderr, "usage: %s [DUMP] > trace.json\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if(2 == argc) {
+		in = fopen(argv[1], "rb");
+		if(NULL == in) {
+			perror(argv[1]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if( (fread(header, 1, sizeof(header), in) != sizeof(header)) ||
+		(memcmp(header, "cTR", 3) != 0) || (header[3] != TRACE_VERSION) ) {
+		fprintf(stderr, "trace2json: not a cuteOS trace dump (version %d)\n", TRACE_VERSION);
+		return EXIT_FAILURE;
+	}
+	inc_per_ms = read_u16(&header[4]);
+	count = read_u16(&header[6]);
+	lost = read_u16(&header[8]);
+	if(0 == inc_per_ms) {
+		fprintf(stderr, "trace2json: null Timer 2 rate\n");
+		return EXIT_FAILURE;
+	}
+	if(lost != 0) {
+		fprintf(stderr, "trace2json: %u%s older events were overwritten before the dump\n",
+				lost, (0xFFFF == lost) ? " or more" : "");
+	}
+
+	printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	write_event("thread_name", 'M', TID_ISR, 0.0, "\"name\": \"isr\"", &first);
+	write_event("thread_name", 'M', TID_TASKS, 0.0, "\"name\": \"tasks\"", &first);
+
+	for(i = 0; i < count; ++i) {
+		if(fread(event, 1, sizeof(event), in) != sizeof(event)) {
+			fprintf(stderr, "trace2json: dump truncated after %u of %u events\n", i, count);
+			break;
+		}
+
+		/*!< Unwrap the 16-bit time: the events are less than 65536 increments apart */
+		stamp = read_u16(&event[2]);
+		if(i != 0) {
+			time += (uint16_t)(stamp - last_stamp);
+		}
+		last_stamp = stamp;
+		ts_us = ((double)time * 1000.0) / inc_per_ms;
+
+		switch(event[0]) {
+		case TRACE_TICK:
+			snprintf(args, sizeof(args), "\"ticks\": %u", event[1]);
+			write_event("tick", 'i', TID_ISR, ts_us, args, &first);
+			break;
+		case TRACE_TASK_START:
+		case TRACE_TIMER_START:
+			snprintf(name, sizeof(name), "%s %u", (TRACE_TASK_START == event[0]) ? "task" : "timer", event[1]);
+			write_event(name, 'B', TID_TASKS, ts_us, NULL, &first);
+			open_slice = event[0];
+			break;
+		case TRACE_TASK_END:
+		case TRACE_TIMER_END:
+			/*!< The start of the oldest slice may have been overwritten */
+			if(open_slice == event[0] - 1) {
+				snprintf(name, sizeof(name), "%s %u", (TRACE_TASK_END == event[0]) ? "task" : "timer", event[1]);
+				write_event(name, 'E', TID_TASKS, ts_us, NULL, &first);
+			}
+			open_slice = -1;
+			break;
+		case TRACE_TASK_CREATE:
+		case TRACE_TASK_REMOVE:
+		case TRACE_OVERRUN:
+			snprintf(name, sizeof(name), "%s %u",
+					 (TRACE_TASK_CREATE == event[0]) ? "create" : (TRACE_TASK_REMOVE == event[0]) ? "remove" : "overrun",
+					 event[1]);
+			write_event(name, 'i', TID_TASKS, ts_us, NULL, &first);
+			break;
+		default:
+			fprintf(stderr, "trace2json: unknown event type 0x%02X skipped\n", event[0]);
+			break;
+		}
+	}
+
+	printf("\n]}\n");
+
+	if(in != stdin) {
+		fclose(in);
+	}
+
+	return EXIT_SUCCESS;
+}